@@ -0,0 +1,151 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+#pragma once
+//=============================================================================
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+//== CLASS DEFINITION =========================================================
+
+/** \class Arena Arena.h
+ Memory arena handing out 64-byte aligned blocks by bumping a pointer.
+ Individual allocations are never freed, all memory is released at once by
+ reset(), which is O(1). The capacity should be planned with reserve() before
+ building a scene; if it is exceeded, additional blocks are allocated.
+ */
+class Arena
+{
+public:
+    /// alignment of all allocations (cache line size)
+    static const size_t alignment = 64;
+
+    /// constructor (does not allocate any memory)
+    Arena();
+
+    /// destructor, frees all memory
+    ~Arena();
+
+    /// reserve one contiguous block of at least `bytes` bytes. releases all
+    /// previous allocations. on Linux the block can be backed by huge pages.
+    void reserve(size_t bytes, bool huge_pages = false);
+
+    /// allocate `bytes` bytes, aligned to 64 bytes
+    void* allocate(size_t bytes);
+
+    /// release all allocations at once, keeps the reserved memory
+    void reset();
+
+    /// size of the main block
+    size_t capacity() const { return main_.size; }
+
+    /// number of bytes allocated since the last reset
+    size_t used() const { return used_; }
+
+    /// round `bytes` up to a multiple of the alignment
+    static size_t aligned_size(size_t bytes)
+    {
+        return (bytes + alignment - 1) & ~(alignment - 1);
+    }
+
+    /// allocate aligned memory from the heap (for allocations without arena)
+    static void* aligned_malloc(size_t bytes);
+    /// free memory allocated with aligned_malloc()
+    static void aligned_free(void* ptr);
+
+private:
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /// a contiguous block of memory
+    struct Block
+    {
+        char* data;  ///< begin of the block
+        size_t size; ///< size in bytes
+        bool mapped; ///< allocated with mmap (huge pages)?
+    };
+
+    /// allocate a block of `bytes` bytes
+    static Block allocate_block(size_t bytes, bool huge_pages);
+    /// free a block
+    static void free_block(Block& block);
+
+    Block main_;                  ///< the reserved block
+    size_t offset_;               ///< first free byte in the main block
+    std::vector<Block> overflow_; ///< blocks allocated after main_ was full
+    size_t used_;                 ///< bytes allocated since last reset
+    bool huge_pages_;             ///< use huge pages for the main block?
+};
+
+//=============================================================================
+
+/** \class ArenaAllocator Arena.h
+ STL allocator carving memory from an Arena. Deallocation is a no-op, the
+ memory is released by Arena::reset(). Without arena it falls back to aligned
+ heap allocations.
+ */
+template <class T>
+class ArenaAllocator
+{
+public:
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    /// construct allocator for `arena` (or the heap if nullptr)
+    ArenaAllocator(Arena* arena = nullptr) : arena_(arena) {}
+
+    /// copy from allocator of another type
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& a) : arena_(a.arena())
+    {
+    }
+
+    /// allocate memory for `n` objects
+    T* allocate(size_t n)
+    {
+        if (arena_)
+            return static_cast<T*>(arena_->allocate(n * sizeof(T)));
+        return static_cast<T*>(Arena::aligned_malloc(n * sizeof(T)));
+    }
+
+    /// free memory (only if it was not taken from an arena)
+    void deallocate(T* p, size_t)
+    {
+        if (!arena_)
+            Arena::aligned_free(p);
+    }
+
+    /// the arena memory is taken from
+    Arena* arena() const { return arena_; }
+
+private:
+    Arena* arena_;
+};
+
+template <class T, class U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+    return a.arena() == b.arena();
+}
+
+template <class T, class U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+    return a.arena() != b.arena();
+}
+
+/// std::vector taking its memory from an Arena
+template <class T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+//=============================================================================
@@ -0,0 +1,151 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+
+#include "DistanceField.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+//== IMPLEMENTATION ==========================================================
+
+DistanceField::DistanceField(vec2 bbmin, vec2 bbmax, unsigned int resolution)
+    : bbmin_(bbmin), version_(0)
+{
+    const vec2 extent = bbmax - bbmin;
+    h_ = std::max(extent[0], extent[1]) / resolution;
+    nx_ = std::ceil(extent[0] / h_) + 1;
+    ny_ = std::ceil(extent[1] / h_) + 1;
+    clear();
+}
+
+//-----------------------------------------------------------------------------
+
+void DistanceField::clear()
+{
+    values_.assign(nx_ * ny_, FLT_MAX);
+    outlines_.clear();
+    ++version_;
+}
+
+//-----------------------------------------------------------------------------
+
+template <class SDF>
+void DistanceField::add(const SDF& sdf)
+{
+    for (unsigned int j = 0; j < ny_; ++j)
+    {
+        for (unsigned int i = 0; i < nx_; ++i)
+        {
+            const vec2 p = bbmin_ + h_ * vec2(i, j);
+            float& d = values_[j * nx_ + i];
+            d = std::min(d, sdf(p));
+        }
+    }
+    ++version_;
+}
+
+//-----------------------------------------------------------------------------
+
+void DistanceField::add_walls(vec2 bbmin, vec2 bbmax)
+{
+    add([&](const vec2& p) {
+        // inside: distance to the closest wall, outside: distance to the box
+        const vec2 lower = p - bbmin, upper = bbmax - p;
+        const float inside = std::min(std::min(lower[0], upper[0]),
+                                      std::min(lower[1], upper[1]));
+        if (inside >= 0.0f)
+            return inside;
+        const vec2 outside(std::max(0.0f, -std::min(lower[0], upper[0])),
+                           std::max(0.0f, -std::min(lower[1], upper[1])));
+        return -norm(outside);
+    });
+
+    outlines_.push_back({vec2(bbmin[0], bbmax[1]), bbmin,
+                         vec2(bbmax[0], bbmin[1]), bbmax,
+                         vec2(bbmin[0], bbmax[1])});
+}
+
+//-----------------------------------------------------------------------------
+
+void DistanceField::add_circle(vec2 center, float radius)
+{
+    add([&](const vec2& p) { return norm(p - center) - radius; });
+
+    std::vector<vec2> outline;
+    for (int i = 0; i <= 64; ++i)
+    {
+        const float a = 2.0 * M_PI * i / 64;
+        outline.push_back(center + radius * vec2(cos(a), sin(a)));
+    }
+    outlines_.push_back(outline);
+}
+
+//-----------------------------------------------------------------------------
+
+void DistanceField::add_polygon(const std::vector<vec2>& corners)
+{
+    if (corners.size() < 3)
+        return;
+
+    add([&](const vec2& p) {
+        // distance to the closest edge, sign by the crossing number
+        float d2 = FLT_MAX;
+        bool inside = false;
+        for (size_t i = 0, j = corners.size() - 1; i < corners.size(); j = i++)
+        {
+            const vec2& a = corners[j];
+            const vec2& b = corners[i];
+            const vec2 e = b - a;
+            const float t =
+                std::min(1.0f, std::max(0.0f, dot(p - a, e) / sqrnorm(e)));
+            d2 = std::min(d2, sqrnorm(p - (a + t * e)));
+
+            if ((a[1] > p[1]) != (b[1] > p[1]) &&
+                p[0] < a[0] + (p[1] - a[1]) / (b[1] - a[1]) * e[0])
+                inside = !inside;
+        }
+        return inside ? -std::sqrt(d2) : std::sqrt(d2);
+    });
+
+    std::vector<vec2> outline(corners);
+    outline.push_back(corners[0]);
+    outlines_.push_back(outline);
+}
+
+//-----------------------------------------------------------------------------
+
+float DistanceField::distance(const vec2& p, vec2& gradient) const
+{
+    // cell and local coordinates, clamped to the grid
+    vec2 q = (p - bbmin_) / h_;
+    const vec2 qc(std::min(std::max(q[0], 0.0f), float(nx_ - 1)),
+                  std::min(std::max(q[1], 0.0f), float(ny_ - 1)));
+    const unsigned int i = std::min((unsigned int)qc[0], nx_ - 2);
+    const unsigned int j = std::min((unsigned int)qc[1], ny_ - 2);
+    const float u = qc[0] - i, v = qc[1] - j;
+
+    // bilinear interpolation
+    const float d00 = value(i, j), d10 = value(i + 1, j);
+    const float d01 = value(i, j + 1), d11 = value(i + 1, j + 1);
+    const float d = (1 - v) * ((1 - u) * d00 + u * d10) +
+                    v * ((1 - u) * d01 + u * d11);
+
+    // gradient of the bilinear interpolant
+    gradient = vec2((1 - v) * (d10 - d00) + v * (d11 - d01),
+                    (1 - u) * (d01 - d00) + u * (d11 - d10));
+    const float l = norm(gradient);
+    gradient = l > 0.0f ? gradient / l : vec2(0, 1);
+
+    // outside the grid: move away from the grid by the clamped distance
+    return d - h_ * norm(q - qc);
+}
+
+//=============================================================================
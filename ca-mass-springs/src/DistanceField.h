@@ -0,0 +1,81 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+#pragma once
+//=============================================================================
+
+#include <pmp/MatVec.h>
+using namespace pmp;
+
+#include <vector>
+
+//== CLASS DEFINITION =========================================================
+
+/** \class DistanceField DistanceField.h
+ Static obstacles represented by a signed distance field sampled on a
+ regular 2D grid. The distance is positive in free space and negative inside
+ obstacles, the union of obstacles is the minimum of their distances. The
+ exact distances are evaluated once at the grid nodes when obstacles are
+ added, lookups interpolate bilinearly and cost O(1) per query, independent
+ of the complexity of the obstacles.
+ */
+class DistanceField
+{
+public:
+    /// constructor, the grid covers [bbmin, bbmax] with `resolution` cells
+    /// along its longer side. initially there are no obstacles.
+    DistanceField(vec2 bbmin = vec2(-1.25, -1.25),
+                  vec2 bbmax = vec2(1.25, 1.25), unsigned int resolution = 256);
+
+    /// remove all obstacles
+    void clear();
+
+    /// walls enclosing the box [bbmin, bbmax], i.e., outside is an obstacle
+    void add_walls(vec2 bbmin, vec2 bbmax);
+
+    /// solid disc
+    void add_circle(vec2 center, float radius);
+
+    /// solid (simple) polygon, given by its corners in either orientation
+    void add_polygon(const std::vector<vec2>& corners);
+
+    /// signed distance of `p` to the obstacles and the (normalized)
+    /// gradient of the distance, which points away from the obstacles.
+    /// outside the grid the distance to the grid is subtracted.
+    float distance(const vec2& p, vec2& gradient) const;
+
+    /// closed outlines of all obstacles, for rendering
+    const std::vector<std::vector<vec2>>& outlines() const
+    {
+        return outlines_;
+    }
+
+    /// incremented whenever obstacles are added or removed
+    unsigned int version() const { return version_; }
+
+private:
+    /// combine `sdf`, evaluated at all grid nodes, with the current field
+    template <class SDF>
+    void add(const SDF& sdf);
+
+    /// value at grid node (i,j)
+    float value(unsigned int i, unsigned int j) const
+    {
+        return values_[j * nx_ + i];
+    }
+
+    vec2 bbmin_;                             ///< lower left grid node
+    float h_;                                ///< grid spacing
+    unsigned int nx_, ny_;                   ///< number of grid nodes
+    std::vector<float> values_;              ///< distances at grid nodes
+    std::vector<std::vector<vec2>> outlines_; ///< outlines of obstacles
+    unsigned int version_;                   ///< changes with obstacles
+};
+
+//=============================================================================
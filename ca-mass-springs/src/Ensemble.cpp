@@ -0,0 +1,350 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+
+#include "Ensemble.h"
+#include "Scenes.h"
+#include "ThreadPool.h"
+
+#include <pmp/Timer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+//== IMPLEMENTATION ==========================================================
+
+Ensemble::Parameters::Parameters()
+{
+    // constructing a system is expensive (e.g. the distance field of the
+    // obstacles), read its defaults only once
+    static const Parameters defaults{MassSpringSystem(false)};
+    *this = defaults;
+}
+
+//-----------------------------------------------------------------------------
+
+Ensemble::Parameters::Parameters(const MassSpringSystem& system)
+{
+    scene = 3;
+    steps = 10000;
+    integration = system.integration_;
+    collisions = system.collisions_;
+    gravity = system.use_gravity_;
+    time_step = system.time_step_;
+    particle_mass = system.particle_mass_;
+    damping = system.damping_;
+    collision_stiffness = system.collision_stiffness_;
+    collision_damping = system.collision_damping_;
+    spring_stiffness = system.spring_stiffness_;
+    spring_damping = system.spring_damping_;
+    area_stiffness = system.area_stiffness_;
+}
+
+//-----------------------------------------------------------------------------
+
+// is `value` an integer in [min, max]? this also rules out NaN and values
+// whose conversion to int is undefined.
+static bool is_integer(float value, float min, float max)
+{
+    return value >= min && value <= max && value == std::floor(value);
+}
+
+//-----------------------------------------------------------------------------
+
+// set parameter `name` to `value`, returns false for unknown names and
+// invalid values
+static bool set_parameter(Ensemble::Parameters& p, const std::string& name,
+                          float value)
+{
+    if (!std::isfinite(value))
+        return false;
+
+    if (name == "scene")
+    {
+        if (!is_integer(value, 1, n_scenes))
+            return false;
+        p.scene = value;
+    }
+    else if (name == "steps")
+    {
+        if (!is_integer(value, 0, 1e9))
+            return false;
+        p.steps = value;
+    }
+    else if (name == "integration")
+    {
+        if (!is_integer(value, MassSpringSystem::Euler,
+                        MassSpringSystem::IMEX))
+            return false;
+        p.integration = value;
+    }
+    else if (name == "collisions")
+    {
+        if (!is_integer(value, MassSpringSystem::No_collisions,
+                        MassSpringSystem::Impulse_based))
+            return false;
+        p.collisions = value;
+    }
+    else if (name == "gravity")
+        p.gravity = value != 0.0;
+    else if (name == "time_step")
+        p.time_step = value;
+    else if (name == "particle_mass")
+        p.particle_mass = value;
+    else if (name == "damping")
+        p.damping = value;
+    else if (name == "collision_stiffness")
+        p.collision_stiffness = value;
+    else if (name == "collision_damping")
+        p.collision_damping = value;
+    else if (name == "spring_stiffness")
+        p.spring_stiffness = value;
+    else if (name == "spring_damping")
+        p.spring_damping = value;
+    else if (name == "area_stiffness")
+        p.area_stiffness = value;
+    else
+        return false;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+// split a line of a CSV file into its fields
+static std::vector<std::string> split_csv(const std::string& line)
+{
+    std::vector<std::string> fields;
+    std::stringstream ss(line);
+    std::string field;
+    while (std::getline(ss, field, ','))
+    {
+        // trim whitespace
+        size_t b = field.find_first_not_of(" \t\r");
+        size_t e = field.find_last_not_of(" \t\r");
+        fields.push_back(b == std::string::npos ? ""
+                                                : field.substr(b, e - b + 1));
+    }
+    return fields;
+}
+
+//-----------------------------------------------------------------------------
+
+bool Ensemble::read(const std::string& filename)
+{
+    std::ifstream ifs(filename);
+    if (!ifs)
+    {
+        std::cerr << "Ensemble: cannot open " << filename << std::endl;
+        return false;
+    }
+
+    // header with parameter names
+    std::string line;
+    if (!std::getline(ifs, line))
+        return false;
+    std::vector<std::string> names = split_csv(line);
+    Parameters defaults;
+    for (const std::string& name : names)
+    {
+        // 1 is a valid value of all parameters
+        if (!set_parameter(defaults, name, 1.0))
+        {
+            std::cerr << "Ensemble: unknown parameter " << name << std::endl;
+            return false;
+        }
+    }
+
+    // one parameter set per line, lines with invalid values are skipped
+    parameters.clear();
+    for (int line_number = 2; std::getline(ifs, line); ++line_number)
+    {
+        std::vector<std::string> values = split_csv(line);
+        if (values.empty() || values[0].empty())
+            continue;
+
+        Parameters p;
+        bool valid = true;
+        for (size_t i = 0; i < names.size() && i < values.size(); ++i)
+        {
+            const char* value = values[i].c_str();
+            char* end;
+            const double v = std::strtod(value, &end);
+            if (end == value || *end != '\0' ||
+                !set_parameter(p, names[i], v))
+            {
+                std::cerr << "Ensemble: invalid " << names[i] << " '"
+                          << values[i] << "' in line " << line_number
+                          << ", skipped" << std::endl;
+                valid = false;
+                break;
+            }
+        }
+        if (valid)
+            parameters.push_back(p);
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void Ensemble::run(unsigned int n_threads)
+{
+    results.resize(parameters.size());
+
+    // simulations differ a lot in cost (scene size, blow-ups stop early),
+    // the work-stealing pool balances them across the cores
+    ThreadPool pool(n_threads);
+    for (size_t i = 0; i < parameters.size(); ++i)
+    {
+        pool.submit([this, i] { results[i] = simulate(parameters[i]); });
+    }
+    pool.wait();
+}
+
+//-----------------------------------------------------------------------------
+
+bool Ensemble::write(const std::string& filename) const
+{
+    std::ofstream ofs(filename);
+    if (!ofs)
+    {
+        std::cerr << "Ensemble: cannot write " << filename << std::endl;
+        return false;
+    }
+
+    ofs << "scene,steps,integration,collisions,gravity,time_step,"
+           "particle_mass,damping,collision_stiffness,collision_damping,"
+           "spring_stiffness,spring_damping,area_stiffness,"
+           "energy_drift,max_penetration,blow_up,steps_done,steps_per_second\n";
+
+    for (size_t i = 0; i < parameters.size() && i < results.size(); ++i)
+    {
+        const Parameters& p = parameters[i];
+        const Result& r = results[i];
+        ofs << p.scene << ',' << p.steps << ',' << p.integration << ','
+            << p.collisions << ',' << p.gravity << ',' << p.time_step << ','
+            << p.particle_mass << ',' << p.damping << ','
+            << p.collision_stiffness << ',' << p.collision_damping << ','
+            << p.spring_stiffness << ',' << p.spring_damping << ','
+            << p.area_stiffness << ',' << r.energy_drift << ','
+            << r.max_penetration << ',' << r.blow_up << ',' << r.steps << ','
+            << r.steps_per_second << '\n';
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+Ensemble::Result Ensemble::simulate(const Parameters& p)
+{
+    // particles get their mass when they are added, so set parameters first
+    MassSpringSystem system(false);
+    system.integration_ = decltype(system.integration_)(p.integration);
+    system.collisions_ = decltype(system.collisions_)(p.collisions);
+    system.use_gravity_ = p.gravity;
+    system.time_step_ = p.time_step;
+    system.particle_mass_ = p.particle_mass;
+    system.damping_ = p.damping;
+    system.collision_stiffness_ = p.collision_stiffness;
+    system.collision_damping_ = p.collision_damping;
+    system.spring_stiffness_ = p.spring_stiffness;
+    system.spring_damping_ = p.spring_damping;
+    system.area_stiffness_ = p.area_stiffness;
+    setup_scene(system, p.scene);
+
+    Result result;
+    result.max_penetration = 0.0;
+    result.blow_up = false;
+    result.steps = 0;
+
+    const double energy0 = energy(system);
+
+    pmp::Timer timer;
+    timer.start();
+    for (; result.steps < p.steps; ++result.steps)
+    {
+        system.time_integration();
+
+        // penetration into walls and obstacles. a particle that is far
+        // outside or not finite anymore indicates a blow-up.
+        for (const Particle& particle : system.particles)
+        {
+            // the distance query must not see positions that are not finite
+            if (!std::isfinite(particle.position[0]) ||
+                !std::isfinite(particle.position[1]))
+            {
+                result.blow_up = true;
+                break;
+            }
+            vec2 normal;
+            float d = -system.obstacles_.distance(particle.position, normal);
+            if (!std::isfinite(d) || d > 10.0)
+            {
+                result.blow_up = true;
+                break;
+            }
+            result.max_penetration = std::max(result.max_penetration, d);
+        }
+        if (result.blow_up)
+            break;
+    }
+    timer.stop();
+
+    const double energy1 = energy(system);
+    result.energy_drift =
+        (energy1 - energy0) / std::max(std::fabs(energy0), 1e-10);
+    if (!std::isfinite(result.energy_drift))
+        result.blow_up = true;
+
+    result.steps_per_second =
+        timer.elapsed() > 0.0 ? 1000.0 * result.steps / timer.elapsed() : 0.0;
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+
+double Ensemble::energy(const MassSpringSystem& system)
+{
+    double e = 0.0;
+
+    // kinetic and gravitational energy (relative to the floor)
+    for (const Particle& p : system.particles)
+    {
+        e += 0.5 * p.mass * sqrnorm(p.velocity);
+        if (system.use_gravity_)
+            e += p.mass * 9.81 * (p.position[1] + 1.0);
+    }
+
+    // spring and area potentials
+    for (const Spring& s : system.springs)
+    {
+        if (s.dead)
+            continue;
+        const double d = s.length() - s.rest_length;
+        e += 0.5 * system.spring_stiffness_ * d * d;
+    }
+    for (const Triangle& t : system.triangles)
+    {
+        if (t.dead)
+            continue;
+        const double d = t.area() - t.rest_area;
+        e += 0.5 * system.area_stiffness_ * d * d;
+    }
+
+    return e;
+}
+
+//=============================================================================
@@ -0,0 +1,84 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+#pragma once
+//=============================================================================
+
+#include "MassSpringSystem.h"
+
+#include <string>
+#include <vector>
+
+//== CLASS DEFINITION =========================================================
+
+/** \class Ensemble Ensemble.h
+ Runs many independent mass-spring simulations with different parameter sets
+ headless on all cores (e.g., for parameter sweeps) and collects summary
+ metrics of each run.
+
+ Parameter sets are read from a CSV file. Its header names the parameters
+ (`scene`, `steps`, `integration`, `collisions`, `gravity`, `time_step`,
+ `particle_mass`, `damping`, `collision_stiffness`, `collision_damping`,
+ `spring_stiffness`, `spring_damping`, `area_stiffness`), each further line
+ is one simulation. Parameters that are not listed keep their default value,
+ lines with invalid values (not a number, integers out of range) are skipped.
+ */
+class Ensemble
+{
+public:
+    /// parameters of one simulation
+    struct Parameters
+    {
+        /// initialize with the defaults of MassSpringSystem
+        Parameters();
+        /// initialize with the current parameters of `system`
+        explicit Parameters(const MassSpringSystem& system);
+
+        int scene;       ///< built-in scene (see Scenes.h)
+        int steps;       ///< number of time steps
+        int integration; ///< time integration scheme
+        int collisions;  ///< collision handling
+        bool gravity;    ///< use gravity?
+        float time_step, particle_mass, damping;
+        float collision_stiffness, collision_damping;
+        float spring_stiffness, spring_damping, area_stiffness;
+    };
+
+    /// summary metrics of one simulation
+    struct Result
+    {
+        float energy_drift;       ///< relative change of total energy
+        float max_penetration;    ///< max. distance of a particle behind a wall
+        bool blow_up;             ///< did the simulation blow up?
+        int steps;                ///< time steps until end or blow-up
+        double steps_per_second;  ///< simulation throughput
+    };
+
+    /// read parameter sets from a CSV file
+    bool read(const std::string& filename);
+
+    /// run all simulations on `n_threads` threads (0: all cores)
+    void run(unsigned int n_threads = 0);
+
+    /// write parameters and results to a CSV file
+    bool write(const std::string& filename) const;
+
+public:
+    std::vector<Parameters> parameters; ///< one parameter set per simulation
+    std::vector<Result> results;        ///< one result per simulation
+
+private:
+    /// run a single simulation
+    static Result simulate(const Parameters& parameters);
+
+    /// total (kinetic and potential) energy of a mass-spring system
+    static double energy(const MassSpringSystem& system);
+};
+
+//=============================================================================
@@ -0,0 +1,56 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+#pragma once
+//=============================================================================
+
+#include "Rasterizer.h"
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <string>
+
+//== CLASS DEFINITION =========================================================
+
+/** \class FrameWriter FrameWriter.h
+ Writes rasterized frames as numbered PNG images (frame_00000.png, ...).
+ Encoding is done by a thread pool, so the simulation continues while
+ earlier frames are compressed. At most two frames per thread are pending,
+ further frames wait until the pool has caught up.
+ */
+class FrameWriter
+{
+public:
+    /// write frames to `directory` (which must exist) with `n_threads`
+    /// encoding threads (0: one per hardware thread)
+    explicit FrameWriter(const std::string& directory,
+                         unsigned int n_threads = 0);
+
+    /// wait for all pending frames
+    ~FrameWriter() { finish(); }
+
+    /// copy the framebuffer of `rasterizer` and encode it in the background
+    void write(const Rasterizer& rasterizer);
+
+    /// wait for all pending frames. returns false if one could not be
+    /// written.
+    bool finish();
+
+    /// number of frames passed to write()
+    unsigned int n_frames() const { return n_frames_; }
+
+private:
+    std::string directory_;               ///< where to write the images
+    ThreadPool pool_;                     ///< encoding threads
+    unsigned int n_frames_;               ///< number of the next frame
+    std::atomic<unsigned int> n_pending_; ///< frames not written yet
+    std::atomic<bool> failed_;            ///< could a frame not be written?
+};
+
+//=============================================================================
@@ -0,0 +1,300 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+
+#include "MassSpringAPI.h"
+#include "MassSpringSystem.h"
+#include "Scenes.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+//== IMPLEMENTATION ==========================================================
+
+/// the opaque handle wraps a headless system
+struct ms_system
+{
+    ms_system() : system(false) {}
+    MassSpringSystem system;
+};
+
+//-----------------------------------------------------------------------------
+
+// pointer to parameter `name` of `s`, or nullptr. `type` is set to 'f'
+// (float), 'b' (bool), 'i' (int), or 'e' (enum), integers and enums must be
+// in [0, max].
+static void* parameter(MassSpringSystem& s, const char* name, char& type,
+                       float& max)
+{
+    struct Entry
+    {
+        const char* name;
+        void* value;
+        char type;
+        float max; ///< largest valid value of integers and enums
+    };
+    const Entry entries[] = {
+        {"integration", &s.integration_, 'e', 3},
+        {"collisions", &s.collisions_, 'e', 2},
+        {"gravity", &s.use_gravity_, 'b', 1},
+        {"time_step", &s.time_step_, 'f', 0},
+        {"auto_time_step", &s.auto_time_step_, 'b', 1},
+        {"particle_mass", &s.particle_mass_, 'f', 0},
+        {"damping", &s.damping_, 'f', 0},
+        {"collision_stiffness", &s.collision_stiffness_, 'f', 0},
+        {"collision_damping", &s.collision_damping_, 'f', 0},
+        {"spring_stiffness", &s.spring_stiffness_, 'f', 0},
+        {"spring_damping", &s.spring_damping_, 'f', 0},
+        {"area_stiffness", &s.area_stiffness_, 'f', 0},
+        {"tear_strain", &s.tear_strain_, 'f', 0},
+        {"sleeping", &s.use_sleeping_, 'b', 1},
+        {"reorder_interval", &s.reorder_interval_, 'i', 1e9},
+    };
+    for (const Entry& e : entries)
+    {
+        if (!strcmp(e.name, name))
+        {
+            type = e.type;
+            max = e.max;
+            return e.value;
+        }
+    }
+    return nullptr;
+}
+
+//-----------------------------------------------------------------------------
+
+// view of the vec2 member at `offset` of all particles
+static ms_view particle_view(const MassSpringSystem& s, size_t offset)
+{
+    ms_view view;
+    view.data = s.particles.empty()
+                    ? nullptr
+                    : reinterpret_cast<const float*>(
+                          reinterpret_cast<const char*>(s.particles.data()) +
+                          offset);
+    view.count = s.particles.size();
+    view.stride = sizeof(Particle);
+    view.components = 2;
+    return view;
+}
+
+//-----------------------------------------------------------------------------
+
+int ms_api_version(void)
+{
+    return MS_API_VERSION;
+}
+
+//-----------------------------------------------------------------------------
+
+ms_system* ms_create(void)
+{
+    return new ms_system;
+}
+
+//-----------------------------------------------------------------------------
+
+void ms_destroy(ms_system* system)
+{
+    delete system;
+}
+
+//-----------------------------------------------------------------------------
+
+int ms_setup_scene(ms_system* system, int scene)
+{
+    return setup_scene(system->system, scene) ? 0 : -1;
+}
+
+//-----------------------------------------------------------------------------
+
+int ms_load_mesh(ms_system* system, const char* filename)
+{
+    return load_scene(system->system, filename) ? 0 : -1;
+}
+
+//-----------------------------------------------------------------------------
+
+int ms_clear(ms_system* system, size_t n_particles, size_t n_springs,
+             size_t n_triangles)
+{
+    system->system.clear(n_particles, n_springs, n_triangles);
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+
+int ms_add_particles(ms_system* system, const float* positions,
+                     const float* velocities, const unsigned char* locked,
+                     size_t n)
+{
+    MassSpringSystem& s = system->system;
+
+    // springs and triangles reference particles, which must not move
+    if ((!s.springs.empty() || !s.triangles.empty()) &&
+        s.particles.size() + n > s.particles.capacity())
+        return -1;
+
+    const size_t first = s.particles.size();
+    std::vector<vec2> p(n);
+    for (size_t i = 0; i < n; ++i)
+        p[i] = vec2(positions[2 * i], positions[2 * i + 1]);
+    s.add_elements(p, std::vector<unsigned int>(),
+                   std::vector<unsigned int>());
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        Particle& particle = s.particles[first + i];
+        if (velocities)
+            particle.velocity =
+                vec2(velocities[2 * i], velocities[2 * i + 1]);
+        if (locked)
+            particle.locked = locked[i] != 0;
+    }
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+
+int ms_add_springs(ms_system* system, const unsigned int* indices, size_t n)
+{
+    MassSpringSystem& s = system->system;
+    for (size_t i = 0; i < 2 * n; ++i)
+        if (indices[i] >= s.particles.size())
+            return -1;
+
+    s.add_elements(std::vector<vec2>(),
+                   std::vector<unsigned int>(indices, indices + 2 * n),
+                   std::vector<unsigned int>());
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+
+int ms_add_triangles(ms_system* system, const unsigned int* indices, size_t n)
+{
+    MassSpringSystem& s = system->system;
+    for (size_t i = 0; i < 3 * n; ++i)
+        if (indices[i] >= s.particles.size())
+            return -1;
+
+    s.add_elements(std::vector<vec2>(), std::vector<unsigned int>(),
+                   std::vector<unsigned int>(indices, indices + 3 * n));
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+
+int ms_set_parameter(ms_system* system, const char* name, float value)
+{
+    MassSpringSystem& s = system->system;
+    char type;
+    float max;
+    void* p = parameter(s, name, type, max);
+    if (!std::isfinite(value) || !p ||
+        ((type == 'i' || type == 'e') && (value < 0.0f || value > max)))
+        return -1;
+
+    switch (type)
+    {
+        case 'f':
+            *static_cast<float*>(p) = value;
+            break;
+        case 'b':
+            *static_cast<bool*>(p) = value != 0.0f;
+            break;
+        case 'i':
+            *static_cast<int*>(p) = int(value);
+            break;
+        case 'e':
+            // enums are written through their own type
+            if (p == &s.integration_)
+                s.integration_ = decltype(s.integration_)(int(value));
+            else
+                s.collisions_ = decltype(s.collisions_)(int(value));
+            break;
+    }
+
+    // changed parameters may disturb resting particles
+    s.wake_up();
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+
+float ms_get_parameter(const ms_system* system, const char* name)
+{
+    const MassSpringSystem& s = system->system;
+    char type;
+    float max;
+    void* p = parameter(const_cast<MassSpringSystem&>(s), name, type, max);
+    if (!p)
+        return NAN;
+
+    switch (type)
+    {
+        case 'f':
+            return *static_cast<float*>(p);
+        case 'b':
+            return *static_cast<bool*>(p);
+        case 'i':
+            return *static_cast<int*>(p);
+        default:
+            if (p == &s.integration_)
+                return s.integration_;
+            return s.collisions_;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void ms_step(ms_system* system, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        system->system.time_integration();
+}
+
+//-----------------------------------------------------------------------------
+
+size_t ms_n_particles(const ms_system* system)
+{
+    return system->system.particles.size();
+}
+
+//-----------------------------------------------------------------------------
+
+size_t ms_n_springs(const ms_system* system)
+{
+    return system->system.springs.size();
+}
+
+//-----------------------------------------------------------------------------
+
+size_t ms_n_triangles(const ms_system* system)
+{
+    return system->system.triangles.size();
+}
+
+//-----------------------------------------------------------------------------
+
+ms_view ms_positions(const ms_system* system)
+{
+    return particle_view(system->system, offsetof(Particle, position));
+}
+
+//-----------------------------------------------------------------------------
+
+ms_view ms_velocities(const ms_system* system)
+{
+    return particle_view(system->system, offsetof(Particle, velocity));
+}
+
+//=============================================================================
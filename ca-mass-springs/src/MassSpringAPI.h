@@ -0,0 +1,108 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+#pragma once
+//=============================================================================
+
+/// C interface for driving headless mass-spring simulations from external
+/// tools. A system is created, filled (built-in scene, mesh file, or bulk
+/// arrays), configured by named parameters, and stepped. Its state is exposed
+/// without copying as strided views into the simulation's own arrays.
+///
+/// Views stay valid until particles are added or the system is cleared,
+/// reordering (parameter "reorder_interval") permutes the particles in
+/// place. All functions returning int return 0 on success and -1 on error.
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_WIN32) && defined(MS_API_EXPORTS)
+#define MS_API __declspec(dllexport)
+#elif defined(_WIN32)
+#define MS_API __declspec(dllimport)
+#else
+#define MS_API __attribute__((visibility("default")))
+#endif
+
+/// version of this interface, incremented on incompatible changes
+#define MS_API_VERSION 1
+
+/// opaque handle of a mass-spring system
+typedef struct ms_system ms_system;
+
+/// read-only view of `count` elements of `components` floats each. element
+/// i starts at (const char*)data + i * stride, stride is given in bytes.
+typedef struct
+{
+    const float* data;
+    size_t count;
+    size_t stride;
+    size_t components;
+} ms_view;
+
+/// version of the linked library (MS_API_VERSION it was built with)
+MS_API int ms_api_version(void);
+
+/// create an empty headless system with default parameters
+MS_API ms_system* ms_create(void);
+/// destroy a system, invalidates all its views
+MS_API void ms_destroy(ms_system* system);
+
+/// replace the content by built-in scene 1..5
+MS_API int ms_setup_scene(ms_system* system, int scene);
+/// replace the content by a triangle mesh (OBJ or OFF)
+MS_API int ms_load_mesh(ms_system* system, const char* filename);
+
+/// remove everything and plan the memory for the given numbers of elements.
+/// all particles have to be added before the first spring or triangle.
+MS_API int ms_clear(ms_system* system, size_t n_particles, size_t n_springs,
+                    size_t n_triangles);
+/// add `n` particles from 2n position coordinates. `velocities` (2n floats)
+/// and `locked` (n flags) may be NULL. fails if springs or triangles exist
+/// and the planned number of particles would be exceeded.
+MS_API int ms_add_particles(ms_system* system, const float* positions,
+                            const float* velocities,
+                            const unsigned char* locked, size_t n);
+/// add `n` springs from 2n particle indices
+MS_API int ms_add_springs(ms_system* system, const unsigned int* indices,
+                          size_t n);
+/// add `n` triangles from 3n particle indices
+MS_API int ms_add_triangles(ms_system* system, const unsigned int* indices,
+                            size_t n);
+
+/// set/get a parameter by name: integration (0 Euler, 1 Midpoint, 2 Verlet,
+/// 3 IMEX), collisions (0 none, 1 force-based, 2 impulse-based), gravity,
+/// time_step, auto_time_step, particle_mass, damping, collision_stiffness,
+/// collision_damping, spring_stiffness, spring_damping, area_stiffness,
+/// tear_strain, sleeping, reorder_interval. set fails for values that are
+/// not finite and for integers out of range and wakes up sleeping particles,
+/// get returns NaN for unknown names.
+MS_API int ms_set_parameter(ms_system* system, const char* name, float value);
+MS_API float ms_get_parameter(const ms_system* system, const char* name);
+
+/// perform `n` time steps
+MS_API void ms_step(ms_system* system, size_t n);
+
+/// number of particles, springs, and triangles (including torn ones)
+MS_API size_t ms_n_particles(const ms_system* system);
+MS_API size_t ms_n_springs(const ms_system* system);
+MS_API size_t ms_n_triangles(const ms_system* system);
+
+/// positions and velocities of all particles (2 components each)
+MS_API ms_view ms_positions(const ms_system* system);
+MS_API ms_view ms_velocities(const ms_system* system);
+
+#ifdef __cplusplus
+}
+#endif
+
+//=============================================================================
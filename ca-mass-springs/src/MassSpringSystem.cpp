@@ -11,17 +11,51 @@
 #include "MassSpringSystem.h"
 #include "simple_shader.h"
 #include <fstream>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <iostream>
+#include <new>
 
 //== MASS SPRING IMPLEMENTATION ==============================================
 
-MassSpringSystem::MassSpringSystem()
+MassSpringSystem::MassSpringSystem(bool use_opengl)
+    : particles(ArenaAllocator<Particle>(&arena_)),
+      springs(ArenaAllocator<Spring>(&arena_)),
+      triangles(ArenaAllocator<Triangle>(&arena_)),
+      cg_x_(ArenaAllocator<vec2>(&arena_)),
+      cg_r_(ArenaAllocator<vec2>(&arena_)),
+      cg_p_(ArenaAllocator<vec2>(&arena_)),
+      cg_Ap_(ArenaAllocator<vec2>(&arena_))
 {
+    use_opengl_ = use_opengl;
     vertexArray_ = 0;
     particleBuffer_ = 0;
     springBuffer_ = 0;
     triangleBuffer_ = 0;
     wallBuffer_ = 0;
 
+    topology_version_ = 1;
+    stability_state_.topology_version = 0;
+    steps_since_reorder_ = 0;
+    n_dead_springs_ = n_dead_triangles_ = 0;
+    steps_since_compaction_ = 0;
+    buffer_topology_version_ = 0;
+    buffer_obstacle_version_ = 0;
+    component_topology_version_ = 0;
+    n_sleeping_ = 0;
+    awake_topology_version_ = 0;
+    sleeping_gravitational_energy_ = 0.0;
+    obstacles_.add_walls(vec2(-1, -1), vec2(1, 1));
+    diagnostics_next_ = 0;
+    energy_reference_ = NAN;
+    n_time_step_reductions_ = 0;
+    time_step_scale_ = 1.0;
+    n_stable_diagnostics_ = 0;
+    steps_since_diagnostics_ = 0;
+    record_diagnostics_ = false;
+
     reset_parameters();
 }
 
@@ -29,6 +63,9 @@ MassSpringSystem::MassSpringSystem()
 
 MassSpringSystem::~MassSpringSystem()
 {
+    if (!use_opengl_)
+        return;
+
     glDeleteBuffers(1, &particleBuffer_);
     glDeleteBuffers(1, &springBuffer_);
     glDeleteBuffers(1, &triangleBuffer_);
@@ -48,6 +85,17 @@ void MassSpringSystem::reset_parameters()
     time_step_ = 0.0005;
 #endif
     integration_ = Euler;
+    auto_time_step_ = false;
+    time_step_safety_ = 0.8;
+    reorder_interval_ = 0;
+    use_huge_pages_ = false;
+    diagnostics_interval_ = 10;
+    energy_growth_limit_ = 0.0;
+    tear_strain_ = 0.0;
+    compaction_interval_ = 100;
+    use_sleeping_ = false;
+    sleep_velocity_ = 0.02;
+    sleep_time_ = 0.5;
 
     particle_radius_ = 0.03;
     particle_mass_ = 0.1;
@@ -63,6 +111,10 @@ void MassSpringSystem::reset_parameters()
     spring_damping_ = 1.0;
     area_stiffness_ = 100000.0;
 
+    imex_spring_threshold_ = 5000.0;
+    cg_iterations_ = 50;
+    cg_tolerance_ = 1e-4;
+
     mouse_spring_.active = false;
     mouse_spring_.stiffness = 0.25f * spring_stiffness_;
     mouse_spring_.damping = spring_damping_;
@@ -72,10 +124,52 @@ void MassSpringSystem::reset_parameters()
 
 void MassSpringSystem::clear()
 {
-    particles.clear();
-    springs.clear();
-    triangles.clear();
+    clear(0, 0, 0);
+}
+
+//-----------------------------------------------------------------------------
+
+void MassSpringSystem::clear(unsigned int n_particles, unsigned int n_springs,
+                             unsigned int n_triangles)
+{
+    // detach all arrays from the arena, then release its memory at once
+    ArenaVector<Particle>(particles.get_allocator()).swap(particles);
+    ArenaVector<Spring>(springs.get_allocator()).swap(springs);
+    ArenaVector<Triangle>(triangles.get_allocator()).swap(triangles);
+    ArenaVector<vec2>(cg_x_.get_allocator()).swap(cg_x_);
+    ArenaVector<vec2>(cg_r_.get_allocator()).swap(cg_r_);
+    ArenaVector<vec2>(cg_p_.get_allocator()).swap(cg_p_);
+    ArenaVector<vec2>(cg_Ap_.get_allocator()).swap(cg_Ap_);
+
+    // plan capacity for particles, springs, triangles, and CG vectors
+    const size_t bytes = Arena::aligned_size(n_particles * sizeof(Particle)) +
+                         Arena::aligned_size(n_springs * sizeof(Spring)) +
+                         Arena::aligned_size(n_triangles * sizeof(Triangle)) +
+                         4 * Arena::aligned_size(n_particles * sizeof(vec2));
+    arena_.reserve(bytes, use_huge_pages_);
+    particles.reserve(n_particles);
+    springs.reserve(n_springs);
+    triangles.reserve(n_triangles);
+    cg_x_.reserve(n_particles);
+    cg_r_.reserve(n_particles);
+    cg_p_.reserve(n_particles);
+    cg_Ap_.reserve(n_particles);
+
+    n_dead_springs_ = n_dead_triangles_ = 0;
+    n_sleeping_ = 0;
+    torn_springs_.clear();
+    torn_triangles_.clear();
+
+    // the energy history of the previous scene is meaningless now
+    diagnostics_.clear();
+    diagnostics_next_ = 0;
+    energy_reference_ = NAN;
+    n_time_step_reductions_ = 0;
+    time_step_scale_ = 1.0;
+    n_stable_diagnostics_ = 0;
+
     mouse_spring_.active = false;
+    ++topology_version_;
     updateOpenGLBuffers();
 }
 
@@ -84,6 +178,7 @@ void MassSpringSystem::clear()
 void MassSpringSystem::add_particle(vec2 position, vec2 velocity, bool locked)
 {
     particles.push_back(Particle(position, velocity, particle_mass_, locked));
+    ++topology_version_;
     updateOpenGLBuffers();
 }
 
@@ -94,6 +189,7 @@ void MassSpringSystem::add_spring(unsigned int i0, unsigned int i1)
     assert(i0 < particles.size());
     assert(i1 < particles.size());
     springs.push_back(Spring(particles[i0], particles[i1]));
+    ++topology_version_;
     updateOpenGLBuffers();
 }
 
@@ -106,6 +202,47 @@ void MassSpringSystem::add_triangle(unsigned int i0, unsigned int i1,
     assert(i1 < particles.size());
     assert(i2 < particles.size());
     triangles.push_back(Triangle(particles[i0], particles[i1], particles[i2]));
+    ++topology_version_;
+    updateOpenGLBuffers();
+}
+
+//-----------------------------------------------------------------------------
+
+void MassSpringSystem::add_elements(
+    const std::vector<vec2>& positions,
+    const std::vector<unsigned int>& spring_indices,
+    const std::vector<unsigned int>& triangle_indices)
+{
+    // springs and triangles reference particles, so the particle array must
+    // not be reallocated once they exist
+    assert((springs.empty() && triangles.empty()) ||
+           particles.size() + positions.size() <= particles.capacity());
+
+    particles.reserve(particles.size() + positions.size());
+    for (const vec2& x : positions)
+        particles.push_back(Particle(x, vec2(0, 0), particle_mass_, false));
+
+    springs.reserve(springs.size() + spring_indices.size() / 2);
+    for (size_t i = 0; i + 1 < spring_indices.size(); i += 2)
+    {
+        assert(spring_indices[i] < particles.size());
+        assert(spring_indices[i + 1] < particles.size());
+        springs.push_back(Spring(particles[spring_indices[i]],
+                                 particles[spring_indices[i + 1]]));
+    }
+
+    triangles.reserve(triangles.size() + triangle_indices.size() / 3);
+    for (size_t i = 0; i + 2 < triangle_indices.size(); i += 3)
+    {
+        assert(triangle_indices[i] < particles.size());
+        assert(triangle_indices[i + 1] < particles.size());
+        assert(triangle_indices[i + 2] < particles.size());
+        triangles.push_back(Triangle(particles[triangle_indices[i]],
+                                     particles[triangle_indices[i + 1]],
+                                     particles[triangle_indices[i + 2]]));
+    }
+
+    ++topology_version_;
     updateOpenGLBuffers();
 }
 
@@ -134,6 +271,13 @@ void MassSpringSystem::add_mouse_spring(vec2 p)
     mouse_spring_.mouse_position = p;
     mouse_spring_.particle_index = get_nearest_particle(p);
     mouse_spring_.active = true;
+
+    // dragging wakes up the particle's cluster
+    if (n_sleeping_ && mouse_spring_.particle_index >= 0)
+    {
+        update_components();
+        wake_component(component_[mouse_spring_.particle_index]);
+    }
     updateOpenGLBuffers();
 }
 
@@ -168,6 +312,9 @@ void MassSpringSystem::clear_mouse_spring()
 
 void MassSpringSystem::updateOpenGLBuffers()
 {
+    if (!use_opengl_)
+        return;
+
     // generate buffers
     if (!vertexArray_)
     {
@@ -180,6 +327,22 @@ void MassSpringSystem::updateOpenGLBuffers()
     }
     glBindVertexArray(vertexArray_);
 
+    // outlines of walls and obstacles
+    if (buffer_obstacle_version_ != obstacles_.version())
+    {
+        std::vector<vec2> wall;
+        outline_sizes_.clear();
+        for (const std::vector<vec2>& outline : obstacles_.outlines())
+        {
+            wall.insert(wall.end(), outline.begin(), outline.end());
+            outline_sizes_.push_back(outline.size());
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, wallBuffer_);
+        glBufferData(GL_ARRAY_BUFFER, wall.size() * sizeof(vec2), wall.data(),
+                     GL_STATIC_DRAW);
+        buffer_obstacle_version_ = obstacles_.version();
+    }
+
     // particle positions
     std::vector<vec2> pos;
     pos.reserve(particles.size()+1);
@@ -197,47 +360,76 @@ void MassSpringSystem::updateOpenGLBuffers()
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0);
     glEnableVertexAttribArray(0);
 
-    // spring edges
-    std::vector<GLuint> edges;
-    edges.reserve(2 * springs.size() + 2);
-    for (const Spring& spring: springs)
+    // the index buffers are only uploaded when the topology has changed.
+    // torn springs and triangles become degenerate (all indices equal).
+    if (buffer_topology_version_ != topology_version_)
+    {
+        // spring edges, the last two entries are reserved for the mouse
+        std::vector<GLuint> edges;
+        edges.reserve(2 * springs.size() + 2);
+        for (const Spring& spring: springs)
+        {
+            edges.push_back(index(spring.particle0));
+            edges.push_back(index(spring.dead ? spring.particle0
+                                              : spring.particle1));
+        }
+        edges.push_back(0);
+        edges.push_back(0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, springBuffer_);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, edges.size() * sizeof(GLuint),
+                     edges.data(), GL_STATIC_DRAW);
+
+        // triangles
+        std::vector<GLuint> tri;
+        tri.reserve(3 * triangles.size());
+        for (const Triangle& triangle: triangles)
+        {
+            tri.push_back(index(triangle.particle0));
+            tri.push_back(index(triangle.dead ? triangle.particle0
+                                              : triangle.particle1));
+            tri.push_back(index(triangle.dead ? triangle.particle0
+                                              : triangle.particle2));
+        }
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, triangleBuffer_);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, tri.size() * sizeof(GLuint),
+                     tri.data(), GL_STATIC_DRAW);
+
+        buffer_topology_version_ = topology_version_;
+    }
+    else
     {
-        edges.push_back(&spring.particle0 - &particles[0]);
-        edges.push_back(&spring.particle1 - &particles[0]);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, springBuffer_);
+        for (unsigned int i : torn_springs_)
+        {
+            const GLuint j = index(springs[i].particle0);
+            const GLuint edge[2] = {j, j};
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 2 * i * sizeof(GLuint),
+                            sizeof(edge), edge);
+        }
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, triangleBuffer_);
+        for (unsigned int i : torn_triangles_)
+        {
+            const GLuint j = index(triangles[i].particle0);
+            const GLuint tri[3] = {j, j, j};
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 3 * i * sizeof(GLuint),
+                            sizeof(tri), tri);
+        }
     }
+    torn_springs_.clear();
+    torn_triangles_.clear();
+
+    // mouse spring from its particle to the mouse position (appended to the
+    // particle positions)
     if (mouse_spring_.active)
     {
-        edges.push_back(mouse_spring_.particle_index);
-        edges.push_back(particles.size());
-    }
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, springBuffer_);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, edges.size() * sizeof(GLuint),
-                 edges.data(), GL_STATIC_DRAW);
-
-    // triangles
-    std::vector<GLuint> tri;
-    tri.reserve(3 * triangles.size());
-    for (const Triangle& triangle: triangles)
-    {
-        tri.push_back(&triangle.particle0 - &particles[0]);
-        tri.push_back(&triangle.particle1 - &particles[0]);
-        tri.push_back(&triangle.particle2 - &particles[0]);
-    }
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, triangleBuffer_);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, tri.size() * sizeof(GLuint),
-                 tri.data(), GL_STATIC_DRAW);
-
-    // walls for collision detection
-    std::vector<vec2> wall;
-    wall.push_back(vec2(-1.0, 1.0));
-    wall.push_back(vec2(-1.0, -1.0));
-    wall.push_back(vec2(1.0, -1.0));
-    wall.push_back(vec2(1.0, 1.0));
-    wall.push_back(vec2(-1.0, 1.0));
-    glBindBuffer(GL_ARRAY_BUFFER, wallBuffer_);
-    glBufferData(GL_ARRAY_BUFFER, wall.size() * sizeof(vec2), wall.data(),
-                 GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0);
+        const GLuint edge[2] = {GLuint(mouse_spring_.particle_index),
+                                GLuint(particles.size())};
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, springBuffer_);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER,
+                        2 * springs.size() * sizeof(GLuint), sizeof(edge),
+                        edge);
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -259,14 +451,18 @@ void MassSpringSystem::draw(const mat4& projection)
     shader_.set_uniform("use_lighting", false);
     shader_.set_uniform("modelview_projection_matrix", projection);
 
-    // draw walls
+    // draw walls and obstacles
     {
         shader_.set_uniform("color", vec3(0.5, 0.5, 0.5));
         glBindBuffer(GL_ARRAY_BUFFER, wallBuffer_);
         glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0);
         glEnableVertexAttribArray(0);
         glDisableVertexAttribArray(1);
-        glDrawArrays(GL_LINE_STRIP, 0, 5);
+        for (unsigned int i = 0, first = 0; i < outline_sizes_.size(); ++i)
+        {
+            glDrawArrays(GL_LINE_STRIP, first, outline_sizes_[i]);
+            first += outline_sizes_[i];
+        }
         glBindBuffer(GL_ARRAY_BUFFER, particleBuffer_);
         glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0);
     }
@@ -278,7 +474,9 @@ void MassSpringSystem::draw(const mat4& projection)
         for (auto p : particles)
         {
             shader_.set_uniform("color",
-                                p.locked ? vec3(1, 0, 0) : vec3(0, 1, 0));
+                                p.locked     ? vec3(1, 0, 0)
+                                : p.sleeping ? vec3(0.4, 0.7, 0.4)
+                                             : vec3(0, 1, 0));
             mat4 mvp =
                 projection *
                 translation_matrix(vec3(p.position[0], p.position[1], 0.0)) *
@@ -318,43 +516,125 @@ void MassSpringSystem::draw(const mat4& projection)
 
 //-----------------------------------------------------------------------------
 
-void MassSpringSystem::compute_forces()
+void MassSpringSystem::rasterize(Rasterizer& rasterizer) const
 {
-    // clear forces
-    for (Particle& p : particles)
-        p.force = vec2(0, 0);
+    rasterizer.clear(vec3(1, 1, 1));
+
+    // triangles first, all other primitives are drawn on top of them
+    for (const Triangle& t : triangles)
+        if (!t.dead)
+            rasterizer.fill_triangle(t.particle0.position,
+                                     t.particle1.position,
+                                     t.particle2.position, vec3(0.8, 1.0, 0.8));
+
+    for (const Spring& s : springs)
+        if (!s.dead)
+            rasterizer.draw_line(s.particle0.position, s.particle1.position,
+                                 1.0, vec3(0, 0, 0));
+    if (mouse_spring_.active)
+        rasterizer.draw_line(
+            particles[mouse_spring_.particle_index].position,
+            mouse_spring_.mouse_position, 1.0, vec3(0, 0, 0));
+
+    for (const Particle& p : particles)
+        rasterizer.fill_disc(p.position, particle_radius_,
+                             p.locked     ? vec3(1, 0, 0)
+                             : p.sleeping ? vec3(0.4, 0.7, 0.4)
+                                          : vec3(0, 1, 0));
+
+    // walls and obstacles
+    for (const std::vector<vec2>& outline : obstacles_.outlines())
+        for (size_t i = 1; i < outline.size(); ++i)
+            rasterizer.draw_line(outline[i - 1], outline[i], 2.0,
+                                 vec3(0.5, 0.5, 0.5));
+}
 
-    // gravity force
-    if (use_gravity_)
-        for (Particle& p : particles)
-            p.force += vec2(0.0, -9.81) * particle_mass_;
+//-----------------------------------------------------------------------------
 
-    // damping force
-    for (Particle& p : particles) {
-        p.force += -damping_ * p.velocity;
-    }
+// apply f to all elements, or only to the ones listed in `awake` if some
+// particles sleep
+template <class Elements, class Function>
+static void for_each_awake(Elements& elements,
+                           const std::vector<unsigned int>& awake,
+                           bool some_sleeping, Function f)
+{
+    if (some_sleeping)
+        for (unsigned int i : awake)
+            f(elements[i]);
+    else
+        for (auto& e : elements)
+            f(e);
+}
 
-    // Force based collisions
-    if (collisions_ == Force_based) {
-        for (Particle& p : particles) {
-            float dist_b = dot((p.position - vec2(0, -1)), vec2(0, 1));
-            float dist_l = dot((p.position - vec2(1, 0)), vec2(-1, 0));
-            float dist_t = dot((p.position - vec2(0, 1)), vec2(0, -1));
-            float dist_r = dot((p.position - vec2(-1, 0)), vec2(1, 0));
+//-----------------------------------------------------------------------------
 
-            if (dist_t < 0.0)
-                p.force += 10.0*collision_stiffness_ * -dist_t * vec2(0, -1);
-            if (dist_r < 0.0)
-                p.force += 10.0*collision_stiffness_ * -dist_r * vec2(1, 0);
-            if (dist_b < 0.0)
-                p.force += 10.0*collision_stiffness_ * -dist_b * vec2(0, 1);
-            if (dist_l < 0.0)
-                p.force += 10.0*collision_stiffness_ * -dist_l * vec2(-1, 0);
-        }
+void MassSpringSystem::compute_forces()
+{
+    ScopedTimer timer(profiler_, "forces");
+
+    // sleeping particles are fixed, their forces are neither computed nor
+    // used by the integrators
+    update_awake_lists();
+    const bool some_sleeping = n_sleeping_ > 0;
+
+    // energies and momentum are accumulated in the force loops, only in the
+    // first force evaluation of a sampled time step
+    const bool diagnose = record_diagnostics_;
+    record_diagnostics_ = false;
+    Diagnostics d = {0.0, 0.0, 0.0, 0.0, 0.0, vec2(0, 0)};
+
+    // gravity and damping force, which also clear the forces of last step
+    const vec2 gravity = use_gravity_ ? vec2(0.0, -9.81) * particle_mass_
+                                      : vec2(0, 0);
+    for_each_awake(particles, awake_particles_, some_sleeping,
+                   [&](Particle& p) {
+                       p.force = gravity;
+                       p.force += -damping_ * p.velocity;
+                       if (diagnose)
+                       {
+                           if (use_gravity_)
+                               d.gravitational +=
+                                   p.mass * 9.81 * (p.position[1] + 1.0);
+                           d.kinetic += 0.5 * p.mass * sqrnorm(p.velocity);
+                           d.momentum += p.mass * p.velocity;
+                       }
+                   });
+
+    // sleeping particles rest, they only add their constant gravitational
+    // energy
+    if (diagnose && some_sleeping && use_gravity_)
+        d.gravitational += sleeping_gravitational_energy_;
+
+    // Force based collisions, penalty force along the gradient of the
+    // obstacles' distance field
+    if (collisions_ == Force_based) {
+        for_each_awake(particles, awake_particles_, some_sleeping,
+                       [&](Particle& p) {
+            vec2 normal;
+            float dist = obstacles_.distance(p.position, normal);
+
+            if (dist < 0.0) {
+                p.force += 10.0*collision_stiffness_ * -dist * normal;
+                if (diagnose)
+                    d.collision += 0.5 * 10.0*collision_stiffness_ * dist * dist;
+            }
+        });
     }
 
-    // Spring forces
-    for (Spring& s : springs) {
+    // Spring forces, overstretched springs tear
+    torn_edges_.clear();
+    for_each_awake(springs, awake_springs_, some_sleeping, [&](Spring& s) {
+        if (s.dead)
+            return;
+        if (tear_strain_ > 0.0 && s.length() > (1.0 + tear_strain_) * s.rest_length) {
+            s.dead = true;
+            ++n_dead_springs_;
+            if (use_opengl_)
+                torn_springs_.push_back(&s - &springs[0]);
+            unsigned int i0 = index(s.particle0), i1 = index(s.particle1);
+            torn_edges_.push_back(std::make_pair(std::min(i0, i1), std::max(i0, i1)));
+            return;
+        }
         vec2 normalized_spring_direction = (s.particle0.position-s.particle1.position)/s.length();
         float stiffness_force = spring_stiffness_ * (s.length() - s.rest_length);
         //float damping_force = spring_damping_ * dot(s.particle0.velocity - s.particle1.velocity, s.particle0.position - s.particle1.position)/s.length();
@@ -362,10 +642,18 @@ void MassSpringSystem::compute_forces()
         vec2 p0_force = -(stiffness_force + damping_force) * normalized_spring_direction;
         s.particle0.force += p0_force;
         s.particle1.force += -p0_force;
-    }
+        if (diagnose)
+            d.spring += 0.5 * stiffness_force * (s.length() - s.rest_length);
+    });
+
+    // triangles at torn springs tear as well
+    if (!torn_edges_.empty())
+        tear_triangles();
 
     // Area forces
-    for (Triangle& t : triangles) {
+    for_each_awake(triangles, awake_triangles_, some_sleeping, [&](Triangle& t) {
+        if (t.dead)
+            return;
         vec2 p0_factor = t.particle2.position - t.particle1.position;
         vec2 p1_factor = t.particle0.position - t.particle2.position;
         vec2 p2_factor = t.particle1.position - t.particle0.position;
@@ -376,7 +664,9 @@ void MassSpringSystem::compute_forces()
         t.particle0.force += p0_force;
         t.particle1.force += p1_force;
         t.particle2.force += p2_force;
-    }
+        if (diagnose)
+            d.area += 0.5 * area_stiffness_ * (t.area() - t.rest_area) * (t.area() - t.rest_area);
+    });
 
     if (mouse_spring_.active == true) {
         vec2 m_pos = mouse_spring_.mouse_position;
@@ -388,6 +678,9 @@ void MassSpringSystem::compute_forces()
         p.force += -(stiffness_force + damping_force) * normalized_spring_direction;
     }
 
+    if (diagnose)
+        add_diagnostics(d);
+
 
 
     /** \todo Compute and sum up all forces for each particle.
@@ -418,8 +711,23 @@ void MassSpringSystem::compute_forces()
 
 void MassSpringSystem::time_integration()
 {
+    ScopedTimer step_timer(profiler_, "step");
+
+    if (auto_time_step_)
+        time_step_ = stable_time_step();
+
     float dt = time_step_;
 
+    // let the first force evaluation of this step record diagnostics
+    if (diagnostics_interval_ > 0 &&
+        ++steps_since_diagnostics_ >= diagnostics_interval_)
+    {
+        record_diagnostics_ = true;
+        steps_since_diagnostics_ = 0;
+    }
+
+    // integration (including force computation)
+    ScopedTimer integration_timer(profiler_, "integration");
     switch (integration_)
     {
         case Euler:
@@ -429,12 +737,12 @@ void MassSpringSystem::time_integration()
 
             // update positions
             for (Particle& p: particles)
-                if (!p.locked)
+                if (!p.is_fixed())
                     p.position += dt * p.velocity;
 
             // update velocities
             for (Particle& p: particles)
-                if (!p.locked)
+                if (!p.is_fixed())
                     p.velocity += dt * p.force / p.mass;
 
             break;
@@ -446,7 +754,7 @@ void MassSpringSystem::time_integration()
             compute_forces();
 
             for (Particle& p: particles)
-                if (!p.locked) {
+                if (!p.is_fixed()) {
                     p.position_t = p.position;
                     p.velocity_t = p.velocity;
                     p.position += (dt/2) * p.velocity;
@@ -456,7 +764,7 @@ void MassSpringSystem::time_integration()
             compute_forces();
 
             for (Particle& p: particles) {
-                if (!p.locked) {
+                if (!p.is_fixed()) {
                     p.position = p.position_t + dt * p.velocity;
                     p.velocity = p.velocity_t + dt * p.force / p.mass;
                 }
@@ -469,7 +777,7 @@ void MassSpringSystem::time_integration()
         {
             compute_forces();
             for (Particle& p : particles) {
-                if (!p.locked) {
+                if (!p.is_fixed()) {
                     p.position += dt * p.velocity + (dt*dt)/2 * (p.force / p.mass);
                     p.acceleration = p.force / p.mass;
                 }
@@ -477,42 +785,939 @@ void MassSpringSystem::time_integration()
             compute_forces();
 
             for (Particle& p : particles) {
-                if (!p.locked) {
+                if (!p.is_fixed()) {
                     p.velocity += dt * ((p.acceleration + (p.force / p.mass))/2);
                 }
             }
 
             break;
         }
+
+        case IMEX:
+        {
+            // all forces are evaluated at the current state, the stiff ones
+            // (area forces and stiff springs) additionally enter the
+            // implicit velocity update
+            compute_forces();
+            implicit_velocity_update(dt);
+
+            // update positions with the new velocities
+            for (Particle& p: particles)
+                if (!p.is_fixed())
+                    p.position += dt * p.velocity;
+
+            break;
+        }
     }
+    integration_timer.stop();
 
     // impulse-based collision handling
     if (collisions_ == Impulse_based)
     {
+        ScopedTimer timer(profiler_, "collisions");
         impulse_based_collisions();
     }
 
+    // deactivate resting and wake up disturbed clusters
+    if (use_sleeping_)
+    {
+        ScopedTimer timer(profiler_, "sleeping");
+        update_sleeping(dt);
+    }
+    else if (n_sleeping_)
+    {
+        wake_up();
+    }
+
+    // remove torn springs and triangles from time to time
+    if (compaction_interval_ > 0 &&
+        ++steps_since_compaction_ >= compaction_interval_)
+    {
+        steps_since_compaction_ = 0;
+        if (n_dead_springs_ || n_dead_triangles_)
+        {
+            ScopedTimer timer(profiler_, "compaction");
+            compact();
+        }
+    }
+
+    // restore memory locality after particles have drifted
+    if (reorder_interval_ > 0 && ++steps_since_reorder_ >= reorder_interval_)
+    {
+        ScopedTimer timer(profiler_, "reorder");
+        reorder_particles();
+    }
+
     // finally update OpenGL buffers
+    ScopedTimer upload_timer(profiler_, "upload");
     updateOpenGLBuffers();
 }
 
 //-----------------------------------------------------------------------------
 
-void MassSpringSystem::impulse_based_collisions()
+// number of diagnostics samples kept in the ring buffer
+static const unsigned int max_diagnostics = 512;
+
+// lowest factor energy blow-ups can reduce the automatic time step by
+static const float min_time_step_scale = 1.0f / 64.0f;
+
+// number of diagnostics samples without blow-up before the automatic time
+// step is doubled again
+static const int stable_diagnostics_to_recover = 100;
+
+//-----------------------------------------------------------------------------
+
+void MassSpringSystem::add_diagnostics(const Diagnostics& d)
 {
-    for (Particle& p : particles) {
-        vec2 normal;
+    // energy blow-up: compare to the lowest energy since the last change of
+    // the time step, which also catches slow exponential growth. the mouse
+    // spring adds energy that is not accounted for, so it resets the
+    // reference, and a state that is not finite cannot be rescued anymore.
+    const double energy = d.total();
+    if (energy_growth_limit_ > 0.0 && std::isfinite(energy_reference_) &&
+        !mouse_spring_.active &&
+        (!std::isfinite(energy) ||
+         energy > energy_growth_limit_ * std::max(energy_reference_, 1e-3)))
+    {
+        // the current step still uses the old time step
+        if (auto_time_step_)
+            time_step_scale_ = std::max(0.5f * time_step_scale_,
+                                        min_time_step_scale);
+        else
+            time_step_ = std::max(0.5f * time_step_, 1e-7f);
+        ++n_time_step_reductions_;
+        n_stable_diagnostics_ = 0;
+        energy_reference_ = energy;
+    }
+    else
+    {
+        if (mouse_spring_.active || energy < energy_reference_ ||
+            std::isnan(energy_reference_))
+            energy_reference_ = energy;
+
+        // the energy stayed bounded for a while: carefully try a larger
+        // automatic time step again
+        if (time_step_scale_ < 1.0f &&
+            ++n_stable_diagnostics_ >= stable_diagnostics_to_recover)
+        {
+            time_step_scale_ = std::min(2.0f * time_step_scale_, 1.0f);
+            n_stable_diagnostics_ = 0;
+        }
+    }
+
+    if (diagnostics_.size() < max_diagnostics)
+    {
+        diagnostics_.push_back(d);
+    }
+    else
+    {
+        diagnostics_[diagnostics_next_] = d;
+        diagnostics_next_ = (diagnostics_next_ + 1) % max_diagnostics;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+const MassSpringSystem::Diagnostics& MassSpringSystem::diagnostics(
+    unsigned int i) const
+{
+    return diagnostics_[(diagnostics_next_ + i) % diagnostics_.size()];
+}
+
+//-----------------------------------------------------------------------------
+
+void MassSpringSystem::implicit_velocity_update(float dt)
+{
+    const unsigned int n = particles.size();
+    const bool use_springs = implicit_springs();
+    const float dt2 = dt * dt;
+
+    cg_x_.resize(n);
+    cg_r_.resize(n);
+    cg_p_.resize(n);
+    cg_Ap_.resize(n);
+
+    // initial guess: explicit velocity update. locked and sleeping particles
+    // do not move, so their velocity is fixed to zero in the linear system.
+    for (unsigned int i = 0; i < n; ++i)
+    {
+        const Particle& p = particles[i];
+        cg_x_[i] = p.is_fixed() ? vec2(0, 0) : p.velocity + dt * p.force / p.mass;
+    }
 
-        if (p.position[0] < -1.0) {
-            normal = vec2(1,0);
-        } else if (p.position[0] > 1.0) {
-            normal = vec2(-1,0);
-        } else if (p.position[1] < -1.0) {
-            normal = vec2(0,1);
-        }else if (p.position[1] > 1.0) {
-            normal = vec2(0,-1);
-        } else {
+    // residual r = b - A x with b = M v + dt f and A = M + dt^2 K
+    stiffness_product(cg_x_, cg_Ap_, true, use_springs);
+    float rr = 0.0, bb = 0.0;
+    for (unsigned int i = 0; i < n; ++i)
+    {
+        const Particle& p = particles[i];
+        if (p.is_fixed())
+        {
+            cg_r_[i] = vec2(0, 0);
+        }
+        else
+        {
+            vec2 b = p.mass * p.velocity + dt * p.force;
+            cg_r_[i] = b - (p.mass * cg_x_[i] + dt2 * cg_Ap_[i]);
+            bb += dot(b, b);
+        }
+        cg_p_[i] = cg_r_[i];
+        rr += dot(cg_r_[i], cg_r_[i]);
+    }
+
+    // conjugate gradients
+    const float tolerance = cg_tolerance_ * cg_tolerance_ * bb;
+    for (int iter = 0; iter < cg_iterations_ && rr > tolerance; ++iter)
+    {
+        stiffness_product(cg_p_, cg_Ap_, true, use_springs);
+        float pAp = 0.0;
+        for (unsigned int i = 0; i < n; ++i)
+        {
+            const Particle& p = particles[i];
+            cg_Ap_[i] = p.is_fixed() ? vec2(0, 0)
+                                     : p.mass * cg_p_[i] + dt2 * cg_Ap_[i];
+            pAp += dot(cg_p_[i], cg_Ap_[i]);
+        }
+        if (pAp <= 0.0)
+            break;
+
+        const float alpha = rr / pAp;
+        float rr_new = 0.0;
+        for (unsigned int i = 0; i < n; ++i)
+        {
+            cg_x_[i] += alpha * cg_p_[i];
+            cg_r_[i] -= alpha * cg_Ap_[i];
+            rr_new += dot(cg_r_[i], cg_r_[i]);
+        }
+
+        const float beta = rr_new / rr;
+        rr = rr_new;
+        for (unsigned int i = 0; i < n; ++i)
+            cg_p_[i] = cg_r_[i] + beta * cg_p_[i];
+    }
+
+    // store new velocities
+    for (unsigned int i = 0; i < n; ++i)
+        if (!particles[i].is_fixed())
+            particles[i].velocity = cg_x_[i];
+}
+
+//-----------------------------------------------------------------------------
+
+void MassSpringSystem::stiffness_product(const ArenaVector<vec2>& x,
+                                         ArenaVector<vec2>& y, bool use_area,
+                                         bool use_springs) const
+{
+    for (vec2& yi : y)
+        yi = vec2(0, 0);
+
+    // the awake lists are updated by compute_forces() and
+    // estimate_stable_time_steps()
+    const bool some_sleeping = n_sleeping_ > 0;
+    assert(!some_sleeping || awake_topology_version_ == topology_version_);
+
+    // area forces: Gauss-Newton approximation K = k_A * g g^T, with g being
+    // the gradient of the triangle area w.r.t. its corners
+    if (use_area)
+    {
+        for_each_awake(triangles, awake_triangles_, some_sleeping,
+                       [&](const Triangle& t) {
+            if (t.dead)
+                return;
+            const unsigned int i0 = index(t.particle0);
+            const unsigned int i1 = index(t.particle1);
+            const unsigned int i2 = index(t.particle2);
+            const vec2& p0 = t.particle0.position;
+            const vec2& p1 = t.particle1.position;
+            const vec2& p2 = t.particle2.position;
+            const vec2 g0 = 0.5 * perp(p2 - p1);
+            const vec2 g1 = 0.5 * perp(p0 - p2);
+            const vec2 g2 = 0.5 * perp(p1 - p0);
+            const float s = area_stiffness_ * (dot(g0, x[i0]) + dot(g1, x[i1]) +
+                                               dot(g2, x[i2]));
+            y[i0] += s * g0;
+            y[i1] += s * g1;
+            y[i2] += s * g2;
+        });
+    }
+
+    // springs: full stiffness along the spring direction d, the transversal
+    // part (1 - L/l)(I - d d^T) is clamped to zero for compressed springs
+    if (use_springs)
+    {
+        for_each_awake(springs, awake_springs_, some_sleeping,
+                       [&](const Spring& s) {
+            if (s.dead)
+                return;
+            const unsigned int i0 = index(s.particle0);
+            const unsigned int i1 = index(s.particle1);
+            const float l = s.length();
+            const vec2 d = (s.particle0.position - s.particle1.position) / l;
+            const vec2 dx = x[i0] - x[i1];
+            const float dd = dot(d, dx);
+            const float transversal = std::max(0.0f, 1.0f - s.rest_length / l);
+            const vec2 f =
+                spring_stiffness_ * (dd * d + transversal * (dx - dd * d));
+            y[i0] += f;
+            y[i1] -= f;
+        });
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+// interleave the lower 16 bits of x and y
+static uint32_t morton_code(uint32_t x, uint32_t y)
+{
+    auto spread = [](uint32_t v) {
+        v &= 0x0000ffff;
+        v = (v | (v << 8)) & 0x00ff00ff;
+        v = (v | (v << 4)) & 0x0f0f0f0f;
+        v = (v | (v << 2)) & 0x33333333;
+        v = (v | (v << 1)) & 0x55555555;
+        return v;
+    };
+    return spread(x) | (spread(y) << 1);
+}
+
+//-----------------------------------------------------------------------------
+
+void MassSpringSystem::reorder_particles()
+{
+    steps_since_reorder_ = 0;
+
+    const unsigned int n = particles.size();
+    if (n < 2)
+        return;
+
+    // bounding box of all particles
+    vec2 bbmin(FLT_MAX, FLT_MAX), bbmax(-FLT_MAX, -FLT_MAX);
+    for (const Particle& p : particles)
+    {
+        bbmin = min(bbmin, p.position);
+        bbmax = max(bbmax, p.position);
+    }
+    const float sx = 65535.0f / std::max(bbmax[0] - bbmin[0], FLT_MIN);
+    const float sy = 65535.0f / std::max(bbmax[1] - bbmin[1], FLT_MIN);
+
+    // sort particles by the Morton code of their quantized position
+    std::vector<std::pair<uint32_t, unsigned int>> order(n);
+    for (unsigned int i = 0; i < n; ++i)
+    {
+        const vec2 q = particles[i].position - bbmin;
+        order[i] = std::make_pair(morton_code(q[0] * sx, q[1] * sy), i);
+    }
+    std::sort(order.begin(), order.end());
+
+    std::vector<unsigned int> new_index(n);
+    for (unsigned int i = 0; i < n; ++i)
+        new_index[order[i].second] = i;
+
+    // springs with remapped indices, first particle has the smaller index.
+    // torn springs and triangles are dropped.
+    struct SpringData
+    {
+        unsigned int i0, i1;
+        float rest_length;
+        bool operator<(const SpringData& s) const
+        {
+            return i0 < s.i0 || (i0 == s.i0 && i1 < s.i1);
+        }
+    };
+    std::vector<SpringData> spring_data;
+    spring_data.reserve(springs.size());
+    for (const Spring& s : springs)
+    {
+        if (s.dead)
+            continue;
+        unsigned int i0 = new_index[index(s.particle0)];
+        unsigned int i1 = new_index[index(s.particle1)];
+        if (i0 > i1)
+            std::swap(i0, i1);
+        spring_data.push_back({i0, i1, s.rest_length});
+    }
+    std::sort(spring_data.begin(), spring_data.end());
+
+    // triangles with remapped indices, rotated such that the first particle
+    // has the smallest index (which preserves the orientation)
+    struct TriangleData
+    {
+        unsigned int i0, i1, i2;
+        float rest_area;
+        bool operator<(const TriangleData& t) const { return i0 < t.i0; }
+    };
+    std::vector<TriangleData> triangle_data;
+    triangle_data.reserve(triangles.size());
+    for (const Triangle& t : triangles)
+    {
+        if (t.dead)
+            continue;
+        unsigned int i0 = new_index[index(t.particle0)];
+        unsigned int i1 = new_index[index(t.particle1)];
+        unsigned int i2 = new_index[index(t.particle2)];
+        while (i0 > i1 || i0 > i2)
+        {
+            unsigned int tmp = i0;
+            i0 = i1;
+            i1 = i2;
+            i2 = tmp;
+        }
+        triangle_data.push_back({i0, i1, i2, t.rest_area});
+    }
+    std::stable_sort(triangle_data.begin(), triangle_data.end());
+
+    // permute particles. the arrays are refilled in place, such that no
+    // new memory is taken from the arena.
+    std::vector<Particle> reordered;
+    reordered.reserve(n);
+    for (unsigned int i = 0; i < n; ++i)
+        reordered.push_back(particles[order[i].second]);
+    particles.assign(reordered.begin(), reordered.end());
+
+    // rebuild springs and triangles, since they reference the particles
+    springs.clear();
+    for (const SpringData& s : spring_data)
+    {
+        springs.push_back(Spring(particles[s.i0], particles[s.i1]));
+        springs.back().rest_length = s.rest_length;
+    }
+
+    triangles.clear();
+    for (const TriangleData& t : triangle_data)
+    {
+        triangles.push_back(
+            Triangle(particles[t.i0], particles[t.i1], particles[t.i2]));
+        triangles.back().rest_area = t.rest_area;
+    }
+
+    if (mouse_spring_.active)
+        mouse_spring_.particle_index = new_index[mouse_spring_.particle_index];
+
+    n_dead_springs_ = n_dead_triangles_ = 0;
+    ++topology_version_;
+    updateOpenGLBuffers();
+}
+
+//-----------------------------------------------------------------------------
+
+void MassSpringSystem::update_components()
+{
+    if (component_topology_version_ == topology_version_)
+        return;
+    component_topology_version_ = topology_version_;
+
+    // union-find over springs and triangles
+    const unsigned int n = particles.size();
+    std::vector<unsigned int> parent(n);
+    for (unsigned int i = 0; i < n; ++i)
+        parent[i] = i;
+    auto find = [&](unsigned int i) {
+        while (parent[i] != i)
+            i = parent[i] = parent[parent[i]];
+        return i;
+    };
+    auto unite = [&](const Particle& a, const Particle& b) {
+        parent[find(index(a))] = find(index(b));
+    };
+    for (const Spring& s : springs)
+        if (!s.dead)
+            unite(s.particle0, s.particle1);
+    for (const Triangle& t : triangles)
+    {
+        if (!t.dead)
+        {
+            unite(t.particle0, t.particle1);
+            unite(t.particle0, t.particle2);
+        }
+    }
+
+    // number the components, then sort their particles into buckets
+    std::vector<unsigned int> root_component(n, n);
+    component_.resize(n);
+    component_start_.assign(1, 0);
+    for (unsigned int i = 0; i < n; ++i)
+    {
+        unsigned int& c = root_component[find(i)];
+        if (c == n)
+        {
+            c = component_start_.size() - 1;
+            component_start_.push_back(0);
+        }
+        component_[i] = c;
+        ++component_start_[c + 1];
+    }
+    const unsigned int n_components = component_start_.size() - 1;
+    for (unsigned int c = 0; c < n_components; ++c)
+        component_start_[c + 1] += component_start_[c];
+    std::vector<unsigned int> next(component_start_.begin(),
+                                   component_start_.end() - 1);
+    component_particles_.resize(n);
+    for (unsigned int i = 0; i < n; ++i)
+        component_particles_[next[component_[i]]++] = i;
+
+    rest_time_.assign(n_components, 0.0);
+    component_min_.resize(n_components);
+    component_max_.resize(n_components);
+
+    // components keep sleeping only if all their particles did (tearing and
+    // compaction do not touch sleeping particles, but be safe)
+    for (unsigned int c = 0; c < n_components; ++c)
+    {
+        bool sleeping = true;
+        vec2& bbmin = component_min_[c] = vec2(FLT_MAX, FLT_MAX);
+        vec2& bbmax = component_max_[c] = vec2(-FLT_MAX, -FLT_MAX);
+        for (unsigned int k = component_start_[c];
+             k < component_start_[c + 1]; ++k)
+        {
+            const Particle& p = particles[component_particles_[k]];
+            sleeping = sleeping && p.sleeping;
+            bbmin = min(bbmin, p.position);
+            bbmax = max(bbmax, p.position);
+        }
+        if (!sleeping)
+            wake_component(c);
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void MassSpringSystem::update_sleeping(float dt)
+{
+    update_components();
+
+    const unsigned int n_components = component_start_.size() - 1;
+    const float v2 = sleep_velocity_ * sleep_velocity_;
+    const int mouse_particle =
+        mouse_spring_.active ? mouse_spring_.particle_index : -1;
+
+    // bounding boxes and resting times of awake components
+    std::vector<unsigned int> awake;
+    for (unsigned int c = 0; c < n_components; ++c)
+    {
+        const unsigned int begin = component_start_[c];
+        const unsigned int end = component_start_[c + 1];
+        if (particles[component_particles_[begin]].sleeping)
+            continue;
+
+        vec2 bbmin(FLT_MAX, FLT_MAX), bbmax(-FLT_MAX, -FLT_MAX);
+        bool resting = true;
+        for (unsigned int k = begin; k < end; ++k)
+        {
+            const Particle& p = particles[component_particles_[k]];
+            bbmin = min(bbmin, p.position);
+            bbmax = max(bbmax, p.position);
+            resting = resting && (p.locked || sqrnorm(p.velocity) < v2) &&
+                      int(component_particles_[k]) != mouse_particle;
+        }
+        component_min_[c] = bbmin;
+        component_max_[c] = bbmax;
+        rest_time_[c] = resting ? rest_time_[c] + dt : 0.0f;
+
+        // fall asleep
+        if (rest_time_[c] >= sleep_time_)
+        {
+            for (unsigned int k = begin; k < end; ++k)
+            {
+                Particle& p = particles[component_particles_[k]];
+                p.sleeping = true;
+                p.velocity = vec2(0, 0);
+            }
+            n_sleeping_ += end - begin;
+            awake_topology_version_ = 0;
+            stability_state_.topology_version = 0;
+            energy_reference_ = NAN;
+        }
+        else
+        {
+            awake.push_back(c);
+        }
+    }
+
+    // wake up sleeping components whose (slightly enlarged) bounding box
+    // overlaps the one of a moving component
+    if (!n_sleeping_ || awake.empty())
+        return;
+    const vec2 margin(2.0f * particle_radius_, 2.0f * particle_radius_);
+    for (unsigned int c = 0; c < n_components; ++c)
+    {
+        if (!particles[component_particles_[component_start_[c]]].sleeping)
             continue;
+        for (unsigned int a : awake)
+        {
+            if (component_min_[a][0] <= component_max_[c][0] + margin[0] &&
+                component_min_[c][0] <= component_max_[a][0] + margin[0] &&
+                component_min_[a][1] <= component_max_[c][1] + margin[1] &&
+                component_min_[c][1] <= component_max_[a][1] + margin[1])
+            {
+                wake_component(c);
+                break;
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void MassSpringSystem::wake_component(unsigned int c)
+{
+    for (unsigned int k = component_start_[c]; k < component_start_[c + 1];
+         ++k)
+    {
+        Particle& p = particles[component_particles_[k]];
+        if (p.sleeping)
+        {
+            p.sleeping = false;
+            --n_sleeping_;
+            awake_topology_version_ = 0;
+            stability_state_.topology_version = 0;
+            energy_reference_ = NAN;
+        }
+    }
+    rest_time_[c] = 0.0;
+}
+
+//-----------------------------------------------------------------------------
+
+void MassSpringSystem::wake_up()
+{
+    for (Particle& p : particles)
+        p.sleeping = false;
+    n_sleeping_ = 0;
+    rest_time_.assign(rest_time_.size(), 0.0);
+    awake_topology_version_ = 0;
+    stability_state_.topology_version = 0;
+    energy_reference_ = NAN;
+}
+
+//-----------------------------------------------------------------------------
+
+void MassSpringSystem::update_awake_lists()
+{
+    if (!n_sleeping_ || awake_topology_version_ == topology_version_)
+        return;
+    awake_topology_version_ = topology_version_;
+
+    // all particles of a spring or triangle belong to the same component
+    // and therefore sleep together
+    awake_particles_.clear();
+    sleeping_gravitational_energy_ = 0.0;
+    for (unsigned int i = 0; i < particles.size(); ++i)
+    {
+        const Particle& p = particles[i];
+        if (!p.sleeping)
+            awake_particles_.push_back(i);
+        else
+            sleeping_gravitational_energy_ +=
+                p.mass * 9.81 * (p.position[1] + 1.0);
+    }
+
+    awake_springs_.clear();
+    for (unsigned int i = 0; i < springs.size(); ++i)
+        if (!springs[i].dead && !springs[i].particle0.sleeping)
+            awake_springs_.push_back(i);
+
+    awake_triangles_.clear();
+    for (unsigned int i = 0; i < triangles.size(); ++i)
+        if (!triangles[i].dead && !triangles[i].particle0.sleeping)
+            awake_triangles_.push_back(i);
+}
+
+//-----------------------------------------------------------------------------
+
+void MassSpringSystem::tear_triangles()
+{
+    std::sort(torn_edges_.begin(), torn_edges_.end());
+
+    auto torn = [&](const Particle& a, const Particle& b) {
+        unsigned int i = index(a), j = index(b);
+        if (i > j)
+            std::swap(i, j);
+        return std::binary_search(torn_edges_.begin(), torn_edges_.end(),
+                                  std::make_pair(i, j));
+    };
+
+    for (unsigned int i = 0; i < triangles.size(); ++i)
+    {
+        Triangle& t = triangles[i];
+        if (!t.dead && (torn(t.particle0, t.particle1) ||
+                        torn(t.particle1, t.particle2) ||
+                        torn(t.particle2, t.particle0)))
+        {
+            t.dead = true;
+            ++n_dead_triangles_;
+            if (use_opengl_)
+                torn_triangles_.push_back(i);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void MassSpringSystem::compact()
+{
+    // springs and triangles hold references and cannot be assigned. copy
+    // the survivors aside and rebuild the arrays from them, as in
+    // reorder_particles(), such that no new memory is taken from the arena.
+    std::vector<Spring> live_springs;
+    live_springs.reserve(springs.size());
+    for (const Spring& s : springs)
+        if (!s.dead)
+            live_springs.push_back(s);
+    springs.clear();
+    for (const Spring& s : live_springs)
+        springs.push_back(s);
+
+    std::vector<Triangle> live_triangles;
+    live_triangles.reserve(triangles.size());
+    for (const Triangle& t : triangles)
+        if (!t.dead)
+            live_triangles.push_back(t);
+    triangles.clear();
+    for (const Triangle& t : live_triangles)
+        triangles.push_back(t);
+
+    n_dead_springs_ = n_dead_triangles_ = 0;
+    ++topology_version_;
+    updateOpenGLBuffers();
+}
+
+//-----------------------------------------------------------------------------
+
+bool MassSpringSystem::StabilityState::operator==(const StabilityState& s) const
+{
+    return topology_version == s.topology_version &&
+           particle_mass == s.particle_mass && damping == s.damping &&
+           spring_stiffness == s.spring_stiffness &&
+           spring_damping == s.spring_damping &&
+           area_stiffness == s.area_stiffness &&
+           collision_stiffness == s.collision_stiffness &&
+           mouse_stiffness == s.mouse_stiffness &&
+           imex_spring_threshold == s.imex_spring_threshold &&
+           collisions == s.collisions;
+}
+
+//-----------------------------------------------------------------------------
+
+float MassSpringSystem::stable_time_step()
+{
+    StabilityState state;
+    state.topology_version = topology_version_;
+    state.particle_mass = particle_mass_;
+    state.damping = damping_;
+    state.spring_stiffness = spring_stiffness_;
+    state.spring_damping = spring_damping_;
+    state.area_stiffness = area_stiffness_;
+    state.collision_stiffness = collision_stiffness_;
+    state.mouse_stiffness = mouse_spring_.stiffness;
+    state.imex_spring_threshold = imex_spring_threshold_;
+    state.collisions = collisions_;
+
+    if (!(state == stability_state_))
+    {
+        stability_state_ = state;
+        estimate_stable_time_steps();
+    }
+
+    return time_step_scale_ * time_step_safety_ *
+           stable_time_steps_[integration_];
+}
+
+//-----------------------------------------------------------------------------
+
+int MassSpringSystem::substeps(float duration, int max_substeps) const
+{
+    // clamp before the conversion, a vanishing time step gives infinity
+    const float n = std::ceil(duration / time_step_);
+    return std::max(1, (int)std::min((float)max_substeps, n));
+}
+
+//-----------------------------------------------------------------------------
+
+void MassSpringSystem::estimate_stable_time_steps()
+{
+    // upper bound for the time step, also used if nothing is stiff at all
+    const float max_time_step = 0.01;
+    // lower bound, undamped oscillations are unstable for Euler and Midpoint
+    // with any time step
+    const float min_time_step = 1e-6;
+
+    // nothing moves while all particles sleep. keep the estimate until they
+    // wake up, which invalidates it again.
+    if (!particles.empty() && n_sleeping_ == particles.size())
+        return;
+
+    // stiffness_product() skips sleeping particles
+    update_awake_lists();
+
+    const unsigned int n = particles.size();
+    ArenaVector<vec2> x(n), Kx(n), Cx(n);
+
+    // smallest particle mass (bounds the diagonal stiffness terms below)
+    float min_mass = FLT_MAX;
+    for (const Particle& p : particles)
+        min_mass = std::min(min_mass, p.mass);
+
+    // largest eigenvalue omega^2 of M^-1 K by power iteration. starting
+    // vector is pseudo-random to avoid being orthogonal to the stiffest mode.
+    // the mode itself is kept to estimate its damping afterwards.
+    auto power_iteration = [&](bool use_area, bool use_springs,
+                               float& omega2, float& gamma) {
+        omega2 = gamma = 0.0;
+        if (!n || (!use_area && !use_springs))
+            return;
+
+        for (unsigned int i = 0; i < n; ++i)
+        {
+            unsigned int h = (i + 1) * 2654435761u;
+            x[i] = particles[i].locked
+                       ? vec2(0, 0)
+                       : vec2((h & 0xffff) / 65535.0f - 0.5f,
+                              ((h >> 16) & 0xffff) / 65535.0f - 0.5f);
+        }
+
+        for (int iter = 0; iter < 30; ++iter)
+        {
+            // Rayleigh quotient x^T K x / x^T M x
+            stiffness_product(x, Kx, use_area, use_springs);
+            float xKx = 0.0, xMx = 0.0;
+            for (unsigned int i = 0; i < n; ++i)
+            {
+                xKx += dot(x[i], Kx[i]);
+                xMx += particles[i].mass * dot(x[i], x[i]);
+            }
+            if (xMx <= 0.0)
+                return;
+            omega2 = xKx / xMx;
+
+            // x = M^-1 K x, normalized
+            float l = 0.0;
+            for (unsigned int i = 0; i < n; ++i)
+            {
+                x[i] = particles[i].locked ? vec2(0, 0)
+                                           : Kx[i] / particles[i].mass;
+                l += dot(x[i], x[i]);
+            }
+            if (l <= 0.0)
+                return;
+            l = 1.0 / sqrt(l);
+            for (vec2& xi : x)
+                xi *= l;
+        }
+
+        // damping rate of this mode: x^T C x / x^T M x
+        damping_product(x, Cx);
+        float xCx = 0.0, xMx = 0.0;
+        for (unsigned int i = 0; i < n; ++i)
+        {
+            xCx += dot(x[i], Cx[i]);
+            xMx += particles[i].mass * dot(x[i], x[i]);
+        }
+        gamma = xCx / xMx;
+    };
+
+    // collision and mouse springs act on single particles, their stiffness
+    // simply adds to the bound of the largest eigenvalue
+    float diagonal = mouse_spring_.stiffness / min_mass;
+    if (collisions_ == Force_based)
+        diagonal += 10.0 * collision_stiffness_ / min_mass;
+    if (!n)
+        diagonal = 0.0;
+
+    // stiffest mode of the damped oscillator x'' = -omega^2 x - gamma x',
+    // with eigenvalues mu = -gamma/2 +- sqrt(gamma^2/4 - omega^2).
+    // the time step h is stable if |R(h mu)| <= 1 for the integrator's
+    // stability function R.
+    typedef std::complex<float> complex;
+    auto eigenvalues = [](float omega2, float gamma, complex mu[2]) {
+        complex root = std::sqrt(complex(0.25 * gamma * gamma - omega2, 0));
+        mu[0] = -0.5f * gamma + root;
+        mu[1] = -0.5f * gamma - root;
+    };
+
+    float omega2, gamma;
+    complex mu[2];
+
+    // explicit integrators see all stiffness
+    power_iteration(true, true, omega2, gamma);
+    omega2 += diagonal;
+    eigenvalues(omega2, gamma, mu);
+
+    // Euler: |1 + h mu| <= 1  <=>  h <= -2 Re(mu) / |mu|^2
+    float h = max_time_step;
+    for (int i = 0; i < 2; ++i)
+        if (std::norm(mu[i]) > 0.0)
+            h = std::min(h, -2.0f * mu[i].real() / std::norm(mu[i]));
+    stable_time_steps_[Euler] = std::max(h, min_time_step);
+
+    // Midpoint: |1 + z + z^2/2| <= 1 with z = h mu, found by bisection
+    h = max_time_step;
+    for (int i = 0; i < 2; ++i)
+    {
+        auto stable = [&](float h) {
+            complex z = h * mu[i];
+            return std::abs(1.0f + z + 0.5f * z * z) <= 1.0f + 1e-6f;
+        };
+        if (stable(h))
+            continue;
+        float lo = 0.0, hi = h;
+        for (int iter = 0; iter < 30; ++iter)
+        {
+            float mid = 0.5 * (lo + hi);
+            (stable(mid) ? lo : hi) = mid;
+        }
+        h = lo;
+    }
+    stable_time_steps_[Midpoint] = std::max(h, min_time_step);
+
+    // Verlet: h <= 2 / omega (damping is neglected)
+    stable_time_steps_[Verlet] =
+        omega2 > 0.0 ? std::min(max_time_step, 2.0f / std::sqrt(omega2))
+                     : max_time_step;
+
+    // IMEX: only the explicitly integrated stiffness limits the time step.
+    // positions are updated with the new velocities, i.e., the explicit part
+    // is symplectic Euler, which is stable for h <= 2 / omega.
+    power_iteration(false, !implicit_springs(), omega2, gamma);
+    omega2 += diagonal;
+    stable_time_steps_[IMEX] =
+        omega2 > 0.0 ? std::min(max_time_step, 2.0f / std::sqrt(omega2))
+                     : max_time_step;
+}
+
+//-----------------------------------------------------------------------------
+
+void MassSpringSystem::damping_product(const ArenaVector<vec2>& x,
+                                       ArenaVector<vec2>& y) const
+{
+    for (unsigned int i = 0; i < particles.size(); ++i)
+        y[i] = particles[i].locked ? vec2(0, 0) : damping_ * x[i];
+
+    for (const Spring& s : springs)
+    {
+        if (s.dead)
+            continue;
+        const unsigned int i0 = index(s.particle0);
+        const unsigned int i1 = index(s.particle1);
+        const vec2 d =
+            (s.particle0.position - s.particle1.position) / s.length();
+        const vec2 f = spring_damping_ * dot(d, x[i0] - x[i1]) * d;
+        y[i0] += f;
+        y[i1] -= f;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void MassSpringSystem::impulse_based_collisions()
+{
+    // sleeping particles do not move and cannot collide
+    for_each_awake(particles, awake_particles_, n_sleeping_ > 0,
+                   [&](Particle& p) {
+        // particles inside an obstacle collide, the normal is the gradient
+        // of the obstacles' distance field
+        vec2 normal;
+        if (obstacles_.distance(p.position, normal) >= 0.0) {
+            return;
         }
 
         if (dot(normal, p.velocity) < 0.0) {
@@ -523,7 +1728,7 @@ void MassSpringSystem::impulse_based_collisions()
             p.velocity += (1.0-collision_damping_) * mirrored_delta_v;
             // std::cout << p.velocity << std::endl;
         }
-    }
+    });
     /** \todo Handle collisions based on impulses
      *   - detect whether a particle collides with one of the walls
      *   - detect whether the contact is colliding, i.e., whether
@@ -14,6 +14,10 @@
 #include <Spring.h>
 #include <Triangle.h>
 #include <Sphere.h>
+#include <Arena.h>
+#include <DistanceField.h>
+#include <Profiler.h>
+#include <Rasterizer.h>
 
 #include <pmp/Shader.h>
 using namespace pmp;
@@ -29,8 +33,9 @@ using namespace pmp;
 class MassSpringSystem
 {
 public:
-    /// constructor
-    MassSpringSystem();
+    /// constructor. without OpenGL the system is simulated headless, i.e.,
+    /// it does not create buffers and cannot be drawn.
+    MassSpringSystem(bool use_opengl = true);
 
     /// destructor
     ~MassSpringSystem();
@@ -41,6 +46,11 @@ public:
     /// clear all particles, springs, and triangles
     void clear();
 
+    /// clear all particles, springs, and triangles, and plan the memory for
+    /// a scene with the given number of particles, springs, and triangles
+    void clear(unsigned int n_particles, unsigned int n_springs,
+               unsigned int n_triangles);
+
     /// add a particle
     void add_particle(vec2 position, vec2 velocity, bool locked);
 
@@ -50,6 +60,14 @@ public:
     /// add a triangle
     void add_triangle(unsigned int i0, unsigned int i1, unsigned int i2);
 
+    /// add particles at `positions` (at rest, not locked), springs between
+    /// pairs of `spring_indices`, and triangles of triples of
+    /// `triangle_indices`, which index all particles. updates the OpenGL
+    /// buffers only once, as needed for large meshes.
+    void add_elements(const std::vector<vec2>& positions,
+                      const std::vector<unsigned int>& spring_indices,
+                      const std::vector<unsigned int>& triangle_indices);
+
     /// remove mouse spring
     void clear_mouse_spring();
     /// add mouse spring between mouse pos p and closest particle
@@ -65,16 +83,122 @@ public:
     /// render the mass spring system
     void draw(const pmp::mat4& projection);
 
-    /// perform one time step using either Euler, Midpoint, or Verlet
+    /// render the mass spring system into the framebuffer of `rasterizer`,
+    /// which works without OpenGL (e.g. for headless video export)
+    void rasterize(Rasterizer& rasterizer) const;
+
+    /// perform one time step using either Euler, Midpoint, Verlet, or IMEX
     void time_integration();
 
+    /// conservative estimate of the largest stable time step of the current
+    /// integrator. re-estimated whenever topology or parameters change.
+    float stable_time_step();
+
+    /// number of time steps needed to advance the simulation by `duration`,
+    /// at most `max_substeps`
+    int substeps(float duration, int max_substeps = 1000) const;
+
+    /// sort particles along a Morton curve to improve memory locality.
+    /// remaps springs and triangles and sorts them by their first particle.
+    /// removes torn springs and triangles.
+    void reorder_particles();
+
+    /// remove torn springs and triangles, preserving the order of the others
+    void compact();
+
+    /// wake up all sleeping particles (e.g. after parameters have changed)
+    void wake_up();
+
+    /// number of sleeping particles
+    unsigned int n_sleeping() const { return n_sleeping_; }
+
+    /// number of torn springs that have not been removed yet
+    unsigned int n_dead_springs() const { return n_dead_springs_; }
+    /// number of torn triangles that have not been removed yet
+    unsigned int n_dead_triangles() const { return n_dead_triangles_; }
+
+    /// energies and linear momentum of the system at one time step
+    struct Diagnostics
+    {
+        double kinetic;       ///< kinetic energy
+        double gravitational; ///< gravitational energy (relative to floor)
+        double spring;        ///< potential energy of springs
+        double area;          ///< potential energy of area forces
+        double collision;     ///< potential energy of collision forces
+        vec2 momentum;        ///< linear momentum
+
+        /// total energy
+        double total() const
+        {
+            return kinetic + gravitational + spring + area + collision;
+        }
+    };
+
+    /// number of recorded diagnostics samples
+    unsigned int n_diagnostics() const { return diagnostics_.size(); }
+    /// recorded diagnostics sample `i`, 0 is the oldest one
+    const Diagnostics& diagnostics(unsigned int i) const;
+    /// number of time step reductions due to energy blow-ups since the
+    /// scene has been set up
+    unsigned int n_time_step_reductions() const
+    {
+        return n_time_step_reductions_;
+    }
+
 private: //--- internal functions --------------------------------------------
     /// compute all external and internal forces
     void compute_forces();
 
+    /// implicit velocity update of the IMEX integrator: solves
+    /// (M + dt^2 K) v' = M v + dt f with conjugate gradients, where K is
+    /// the stiffness of the forces treated implicitly
+    void implicit_velocity_update(float dt);
+
+    /// compute y = K x for the (positive semi-definite approximation of the)
+    /// stiffness matrix of area forces and/or springs
+    void stiffness_product(const ArenaVector<vec2>& x, ArenaVector<vec2>& y,
+                           bool use_area, bool use_springs) const;
+
+    /// are springs stiff enough to be handled implicitly by IMEX?
+    bool implicit_springs() const
+    {
+        return spring_stiffness_ > imex_spring_threshold_;
+    }
+
+    /// index of a particle referenced by a spring or triangle
+    unsigned int index(const Particle& p) const { return &p - &particles[0]; }
+
+    /// compute the connected components of the spring/triangle graph
+    void update_components();
+
+    /// put components to sleep that rested for sleep_time_, and wake up
+    /// sleeping components that moving components come close to
+    void update_sleeping(float dt);
+
+    /// wake up the particles of component `c`
+    void wake_component(unsigned int c);
+
+    /// rebuild the lists of awake particles, springs, and triangles if some
+    /// particles sleep and the lists are outdated
+    void update_awake_lists();
+
+    /// mark all triangles containing an edge of torn_edges_ as torn
+    void tear_triangles();
+
+    /// store a diagnostics sample and lower the time step on energy blow-up
+    void add_diagnostics(const Diagnostics& d);
+
     /// perform impulse-based collision handling
     void impulse_based_collisions();
 
+    /// estimate stable time steps of all integrators by a few power
+    /// iterations on the stiffness operator M^-1 K
+    void estimate_stable_time_steps();
+
+    /// compute y = C x for the damping matrix of air and spring damping
+    void damping_product(const ArenaVector<vec2>& x,
+                         ArenaVector<vec2>& y) const;
+
 public: //--- parameters -----------------------------------------------------
     /// value of time-step
     float time_step_;
@@ -103,12 +227,52 @@ public: //--- parameters -----------------------------------------------------
     /// parameter: strength of area-preserving forces
     float area_stiffness_;
 
+    /// parameter: automatically choose the time step (and number of substeps)
+    bool auto_time_step_;
+    /// parameter: fraction of the estimated stable time step to be used
+    float time_step_safety_;
+
+    /// parameter: back large scenes by huge pages (Linux only)
+    bool use_huge_pages_;
+
+    /// parameter: reorder particles every this many time steps (0: never)
+    int reorder_interval_;
+
+    /// parameter: record energies and momentum every this many time steps
+    /// (0: never). they are computed along with the forces.
+    int diagnostics_interval_;
+    /// parameter: halve the time step if the total energy grows by more
+    /// than this factor between two diagnostics samples (0: never)
+    float energy_growth_limit_;
+
+    /// parameter: springs stretched by more than this fraction of their rest
+    /// length tear (0: never)
+    float tear_strain_;
+    /// parameter: remove torn springs and triangles every this many time
+    /// steps (0: only when particles are reordered)
+    int compaction_interval_;
+
+    /// parameter: deactivate resting clusters of particles?
+    bool use_sleeping_;
+    /// parameter: a cluster rests if all its particles are slower than this
+    float sleep_velocity_;
+    /// parameter: time a cluster has to rest before it falls asleep
+    float sleep_time_;
+
+    /// parameter: springs stiffer than this are integrated implicitly by IMEX
+    float imex_spring_threshold_;
+    /// parameter: max. number of CG iterations of the IMEX solve
+    int cg_iterations_;
+    /// parameter: relative residual at which CG of the IMEX solve stops
+    float cg_tolerance_;
+
     /// paramters: which time-integration to use
     enum
     {
         Euler = 0,
         Midpoint = 1,
-        Verlet = 2
+        Verlet = 2,
+        IMEX = 3
     } integration_;
 
     /// parameter: how to handle collisiont
@@ -119,10 +283,21 @@ public: //--- parameters -----------------------------------------------------
         Impulse_based = 2
     } collisions_;
 
+    /// timings of the phases of time_integration()
+    Profiler profiler_;
+
+private:
+    /// memory of all per-particle, per-spring, and per-triangle arrays
+    Arena arena_;
+
 public: //--- simulation data ------------------------------------------------
-    std::vector<Particle> particles; ///< vector of all particles
-    std::vector<Spring> springs;     ///< vector of all springs
-    std::vector<Triangle> triangles; ///< vector of all triangles
+    ArenaVector<Particle> particles; ///< vector of all particles
+    ArenaVector<Spring> springs;     ///< vector of all springs
+    ArenaVector<Triangle> triangles; ///< vector of all triangles
+
+    /// static obstacles particles collide with. by default the walls of the
+    /// box [-1,1]^2, scenes can add further obstacles.
+    DistanceField obstacles_;
 
 private:
     /// the interactive spring controlled by the mouse
@@ -140,10 +315,99 @@ private:
         float damping;
     } mouse_spring_;
 
+    /// temporary vectors for the CG solve of the IMEX integrator
+    ArenaVector<vec2> cg_x_, cg_r_, cg_p_, cg_Ap_;
+
+    /// incremented whenever particles, springs, or triangles change
+    unsigned int topology_version_;
+
+    /// number of time steps since particles have been reordered
+    int steps_since_reorder_;
+
+    /// the state the stable time steps have been estimated for. the estimate
+    /// only covers awake particles, so sleep changes reset topology_version.
+    struct StabilityState
+    {
+        unsigned int topology_version;
+        float particle_mass, damping;
+        float spring_stiffness, spring_damping, area_stiffness;
+        float collision_stiffness, mouse_stiffness, imex_spring_threshold;
+        int collisions;
+
+        bool operator==(const StabilityState& s) const;
+    } stability_state_;
+
+    /// estimated stable time step for each integrator
+    float stable_time_steps_[4];
+
+    /// number of torn springs and triangles not removed yet
+    unsigned int n_dead_springs_, n_dead_triangles_;
+    /// number of time steps since the last compaction
+    int steps_since_compaction_;
+    /// edges of the springs torn in the current force computation, as
+    /// (smaller index, larger index) pairs
+    std::vector<std::pair<unsigned int, unsigned int>> torn_edges_;
+
+    /// connected components of the spring/triangle graph: the particles of
+    /// component c are component_particles_[component_start_[c] ...
+    /// component_start_[c+1]-1]
+    std::vector<unsigned int> component_start_, component_particles_;
+    /// component of each particle
+    std::vector<unsigned int> component_;
+    /// topology version the components have been computed for
+    unsigned int component_topology_version_;
+    /// per component: how long it has been resting, and its bounding box
+    std::vector<float> rest_time_;
+    std::vector<vec2> component_min_, component_max_;
+    /// number of sleeping particles
+    unsigned int n_sleeping_;
+    /// indices of the awake particles and of the live springs and triangles
+    /// between them, only used while some particles sleep
+    std::vector<unsigned int> awake_particles_, awake_springs_,
+        awake_triangles_;
+    /// topology version the awake lists have been built for, 0 after the
+    /// sleep state has changed
+    unsigned int awake_topology_version_;
+    /// gravitational energy of the sleeping particles, which do not move
+    double sleeping_gravitational_energy_;
+
+    /// ring buffer of the last diagnostics samples
+    std::vector<Diagnostics> diagnostics_;
+    /// oldest sample in diagnostics_ (the next one to be overwritten)
+    unsigned int diagnostics_next_;
+    /// lowest total energy since the last change of the time step
+    double energy_reference_;
+    /// number of time step reductions due to energy blow-ups
+    unsigned int n_time_step_reductions_;
+    /// factor applied to the automatic time step after energy blow-ups, it
+    /// recovers toward 1 while the energy stays bounded
+    float time_step_scale_;
+    /// number of diagnostics samples without blow-up since the last change
+    /// of time_step_scale_
+    int n_stable_diagnostics_;
+    /// number of time steps since the last diagnostics sample
+    int steps_since_diagnostics_;
+    /// compute diagnostics in the next call of compute_forces()?
+    bool record_diagnostics_;
+
 private: //--- OpenGL rendering ----------------------------------------------
     /// update OpenGL buffers
     void updateOpenGLBuffers();
 
+    /// use OpenGL for rendering? (false for headless simulations)
+    bool use_opengl_;
+
+    /// topology version of the index buffers, they are only uploaded again
+    /// if it differs from topology_version_
+    unsigned int buffer_topology_version_;
+    /// version of the obstacles in wallBuffer_
+    unsigned int buffer_obstacle_version_;
+    /// number of vertices of each obstacle outline in wallBuffer_
+    std::vector<int> outline_sizes_;
+    /// springs and triangles torn since the last upload, their indices are
+    /// made degenerate in the index buffers
+    std::vector<unsigned int> torn_springs_, torn_triangles_;
+
     Shader shader_;
     Sphere sphere_;
 
@@ -28,15 +28,20 @@ public:
           force(0, 0),
           mass(m),
           locked(l),
+          sleeping(false),
           acceleration(0, 0)
     {
     }
 
+    /// does the particle currently not move (locked or sleeping)?
+    bool is_fixed() const { return locked || sleeping; }
+
     vec2 position; ///< position of the particle
     vec2 velocity; ///< velocity of the particle
     vec2 force;    ///< accumulated force acting on the particle
     float mass;    ///< mass of the particle
     bool locked;   ///< is the particle locked?
+    bool sleeping; ///< is the particle's resting cluster deactivated?
 
     vec2 position_t;   ///< used for Midpoint integration
     vec2 velocity_t;   ///< used for Midpoint integration
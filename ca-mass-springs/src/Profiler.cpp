@@ -0,0 +1,139 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <fstream>
+
+//== IMPLEMENTATION ==========================================================
+
+// maximum number of trace events (about 24MB), recording stops afterwards
+static const size_t max_trace_events = 1000000;
+
+//-----------------------------------------------------------------------------
+
+Profiler::Profiler(unsigned int window)
+    : enabled(true), window_(window), tracing_(false), origin_(clock::now())
+{
+}
+
+//-----------------------------------------------------------------------------
+
+void Profiler::add_sample(const char* name, double start, double duration)
+{
+    int i = find(name);
+    if (i < 0)
+    {
+        i = phases_.size();
+        phases_.push_back(Phase());
+        phases_[i].name = name;
+        phases_[i].next = 0;
+        phases_[i].samples.reserve(window_);
+    }
+    Phase* phase = &phases_[i];
+
+    if (phase->samples.size() < window_)
+        phase->samples.push_back(duration);
+    else
+        phase->samples[phase->next] = duration;
+    phase->next = (phase->next + 1) % window_;
+
+    if (tracing_)
+    {
+        Event event = {name, start, duration};
+        events_.push_back(event);
+        if (events_.size() >= max_trace_events)
+            tracing_ = false;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+int Profiler::find(const char* name) const
+{
+    // phases are named by string literals, so comparing pointers is
+    // usually sufficient
+    for (unsigned int i = 0; i < phases_.size(); ++i)
+        if (phases_[i].name == name || !strcmp(phases_[i].name, name))
+            return i;
+    return -1;
+}
+
+//-----------------------------------------------------------------------------
+
+std::vector<const char*> Profiler::phases() const
+{
+    std::vector<const char*> names;
+    for (const Phase& phase : phases_)
+        names.push_back(phase.name);
+    return names;
+}
+
+//-----------------------------------------------------------------------------
+
+Profiler::Statistics Profiler::statistics(const char* name) const
+{
+    Statistics stats = {0.0, 0.0, 0.0};
+
+    int i = find(name);
+    if (i < 0 || phases_[i].samples.empty())
+        return stats;
+
+    std::vector<double> samples = phases_[i].samples;
+    stats.min = DBL_MAX;
+    for (double s : samples)
+    {
+        stats.min = std::min(stats.min, s);
+        stats.avg += s;
+    }
+    stats.avg /= samples.size();
+
+    size_t k = (samples.size() * 99) / 100;
+    std::nth_element(samples.begin(), samples.begin() + k, samples.end());
+    stats.p99 = samples[k];
+
+    return stats;
+}
+
+//-----------------------------------------------------------------------------
+
+void Profiler::start_trace()
+{
+    events_.clear();
+    tracing_ = true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool Profiler::write_trace(const std::string& filename) const
+{
+    std::ofstream ofs(filename);
+    if (!ofs)
+        return false;
+
+    // complete events ("ph":"X"), timestamps and durations in microseconds
+    ofs << "{\"traceEvents\":[\n";
+    for (size_t i = 0; i < events_.size(); ++i)
+    {
+        const Event& e = events_[i];
+        ofs << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":0,"
+            << "\"tid\":0,\"ts\":" << e.start
+            << ",\"dur\":" << 1000.0 * e.duration << "}"
+            << (i + 1 < events_.size() ? ",\n" : "\n");
+    }
+    ofs << "],\"displayTimeUnit\":\"ms\"}\n";
+
+    return true;
+}
+
+//=============================================================================
@@ -0,0 +1,145 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+#pragma once
+//=============================================================================
+
+#include <pmp/Timer.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+//== CLASS DEFINITION =========================================================
+
+/** \class Profiler Profiler.h
+ Collects the timings of named phases of a simulation step. For each phase
+ the last samples are kept for rolling statistics (min/avg/p99). Optionally
+ all samples are recorded as events that can be exported in the Chrome
+ trace-event format (open in chrome://tracing or ui.perfetto.dev).
+ */
+class Profiler
+{
+public:
+    /// rolling statistics of a phase, in milliseconds
+    struct Statistics
+    {
+        double min; ///< minimum
+        double avg; ///< average
+        double p99; ///< 99th percentile
+    };
+
+    /// constructor, keeps the last `window` samples of each phase
+    explicit Profiler(unsigned int window = 256);
+
+    /// add a sample of phase `name` (a string literal) that started at time
+    /// `start` (see now()) and took `duration` milliseconds
+    void add_sample(const char* name, double start, double duration);
+
+    /// names of all phases measured so far
+    std::vector<const char*> phases() const;
+
+    /// rolling statistics of phase `name`
+    Statistics statistics(const char* name) const;
+
+    /// start recording trace events (discards previous events)
+    void start_trace();
+    /// stop recording trace events
+    void stop_trace() { tracing_ = false; }
+    /// are trace events recorded?
+    bool is_tracing() const { return tracing_; }
+    /// number of recorded trace events
+    size_t n_trace_events() const { return events_.size(); }
+    /// write recorded events as Chrome trace-event JSON file
+    bool write_trace(const std::string& filename) const;
+
+    /// microseconds since the profiler has been created
+    double now() const
+    {
+        return std::chrono::duration<double, std::micro>(clock::now() -
+                                                         origin_)
+            .count();
+    }
+
+public:
+    /// measure timings at all?
+    bool enabled;
+
+private:
+    typedef std::chrono::steady_clock clock;
+
+    /// the last samples of a phase
+    struct Phase
+    {
+        const char* name;            ///< name of the phase
+        std::vector<double> samples; ///< ring buffer of durations [ms]
+        unsigned int next;           ///< next sample to overwrite
+    };
+
+    /// a recorded trace event
+    struct Event
+    {
+        const char* name; ///< name of the phase
+        double start;     ///< start time [us]
+        double duration;  ///< duration [ms]
+    };
+
+    /// index of phase `name`, -1 if it does not exist
+    int find(const char* name) const;
+
+    unsigned int window_;       ///< number of samples kept per phase
+    std::vector<Phase> phases_; ///< all phases
+    std::vector<Event> events_; ///< recorded trace events
+    bool tracing_;              ///< record trace events?
+    clock::time_point origin_;  ///< time of construction
+};
+
+//== CLASS DEFINITION =========================================================
+
+/** \class ScopedTimer Profiler.h
+ Measures the time spent in a scope with a pmp::Timer and reports it as
+ a sample of a phase to a Profiler.
+ */
+class ScopedTimer
+{
+public:
+    /// start measuring phase `name` (a string literal)
+    ScopedTimer(Profiler& profiler, const char* name)
+        : profiler_(profiler), name_(name), active_(profiler.enabled)
+    {
+        if (active_)
+        {
+            start_ = profiler_.now();
+            timer_.start();
+        }
+    }
+
+    /// stop measuring and report the sample
+    ~ScopedTimer() { stop(); }
+
+    /// stop measuring before the end of the scope and report the sample
+    void stop()
+    {
+        if (active_)
+        {
+            timer_.stop();
+            profiler_.add_sample(name_, start_, timer_.elapsed());
+            active_ = false;
+        }
+    }
+
+private:
+    Profiler& profiler_;
+    const char* name_;
+    bool active_;
+    double start_;
+    pmp::Timer timer_;
+};
+
+//=============================================================================
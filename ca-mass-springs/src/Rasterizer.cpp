@@ -0,0 +1,168 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+
+#include "Rasterizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+//== IMPLEMENTATION ==========================================================
+
+// convert color in [0,1]^3 to bytes
+static void to_rgb(const vec3& color, unsigned char rgb[3])
+{
+    for (int i = 0; i < 3; ++i)
+        rgb[i] = std::min(std::max(color[i], 0.0f), 1.0f) * 255.0f + 0.5f;
+}
+
+//-----------------------------------------------------------------------------
+
+// range [first, last] of pixels in [0, n) whose centers are in [lo, hi]
+static void pixel_range(float lo, float hi, unsigned int n, int& first,
+                        int& last)
+{
+    lo = std::min(std::max(std::ceil(lo - 0.5f), 0.0f), float(n));
+    hi = std::min(std::max(std::floor(hi - 0.5f), -1.0f), float(n) - 1);
+    first = lo;
+    last = hi;
+}
+
+//-----------------------------------------------------------------------------
+
+Rasterizer::Rasterizer(unsigned int width, unsigned int height, vec2 bbmin,
+                       vec2 bbmax)
+    : width_(width), height_(height), pixels_(3 * width * height, 255)
+{
+    const vec2 extent = bbmax - bbmin;
+    scale_ = std::min(width / extent[0], height / extent[1]);
+
+    // center of [bbmin, bbmax] maps to the center of the image
+    const vec2 center = 0.5f * (bbmin + bbmax);
+    offset_ = vec2(0.5f * width - scale_ * center[0],
+                   0.5f * height + scale_ * center[1]);
+}
+
+//-----------------------------------------------------------------------------
+
+void Rasterizer::clear(const vec3& color)
+{
+    unsigned char rgb[3];
+    to_rgb(color, rgb);
+    for (size_t i = 0; i < pixels_.size(); i += 3)
+    {
+        pixels_[i] = rgb[0];
+        pixels_[i + 1] = rgb[1];
+        pixels_[i + 2] = rgb[2];
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void Rasterizer::fill_triangle(const vec2& a, const vec2& b, const vec2& c,
+                               const vec3& color)
+{
+    fill_pixel_triangle(to_pixel(a), to_pixel(b), to_pixel(c), color);
+}
+
+//-----------------------------------------------------------------------------
+
+void Rasterizer::fill_pixel_triangle(vec2 a, vec2 b, vec2 c,
+                                     const vec3& color)
+{
+    // counter-clockwise in pixel coordinates (y points down)
+    const float area =
+        (b[0] - a[0]) * (c[1] - a[1]) - (c[0] - a[0]) * (b[1] - a[1]);
+    if (area == 0.0f || std::isnan(area))
+        return;
+    if (area < 0.0f)
+        std::swap(b, c);
+
+    // pixel centers within the bounding box, clipped to the image
+    int x0, x1, y0, y1;
+    pixel_range(std::min({a[0], b[0], c[0]}), std::max({a[0], b[0], c[0]}),
+                width_, x0, x1);
+    pixel_range(std::min({a[1], b[1], c[1]}), std::max({a[1], b[1], c[1]}),
+                height_, y0, y1);
+    if (x0 > x1 || y0 > y1)
+        return;
+
+    unsigned char rgb[3];
+    to_rgb(color, rgb);
+
+    // edge functions, which are linear along rows. they are accumulated in
+    // double precision, so pixels on a shared edge are never missed by both
+    // triangles.
+    auto edge = [](const vec2& p, const vec2& q, double x, double y) {
+        return double(q[0] - p[0]) * (y - p[1]) -
+               double(q[1] - p[1]) * (x - p[0]);
+    };
+    const double d0 = -(b[1] - a[1]);
+    const double d1 = -(c[1] - b[1]);
+    const double d2 = -(a[1] - c[1]);
+    for (int y = y0; y <= y1; ++y)
+    {
+        const double py = y + 0.5, px = x0 + 0.5;
+        double e0 = edge(a, b, px, py);
+        double e1 = edge(b, c, px, py);
+        double e2 = edge(c, a, px, py);
+        for (int x = x0; x <= x1; ++x, e0 += d0, e1 += d1, e2 += d2)
+        {
+            if (e0 >= 0.0 && e1 >= 0.0 && e2 >= 0.0)
+                set(x, y, rgb);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void Rasterizer::draw_line(const vec2& a, const vec2& b, float width,
+                           const vec3& color)
+{
+    // a quad around the segment, extended by half the width at both ends
+    const vec2 pa = to_pixel(a), pb = to_pixel(b);
+    const float l = norm(pb - pa);
+    if (l == 0.0f || std::isnan(l))
+        return;
+    const vec2 t = (0.5f * width / l) * (pb - pa);
+    const vec2 n(-t[1], t[0]);
+
+    fill_pixel_triangle(pa - t - n, pb + t - n, pb + t + n, color);
+    fill_pixel_triangle(pa - t - n, pb + t + n, pa - t + n, color);
+}
+
+//-----------------------------------------------------------------------------
+
+void Rasterizer::fill_disc(const vec2& center, float radius,
+                           const vec3& color)
+{
+    const vec2 c = to_pixel(center);
+    const float r = std::max(scale_ * radius, 0.5f);
+    if (std::isnan(c[0]) || std::isnan(c[1]))
+        return;
+
+    int x0, x1, y0, y1;
+    pixel_range(c[0] - r, c[0] + r, width_, x0, x1);
+    pixel_range(c[1] - r, c[1] + r, height_, y0, y1);
+
+    unsigned char rgb[3];
+    to_rgb(color, rgb);
+    for (int y = y0; y <= y1; ++y)
+    {
+        const float dy = y + 0.5f - c[1];
+        for (int x = x0; x <= x1; ++x)
+        {
+            const float dx = x + 0.5f - c[0];
+            if (dx * dx + dy * dy <= r * r)
+                set(x, y, rgb);
+        }
+    }
+}
+
+//=============================================================================
@@ -0,0 +1,342 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+
+#include "Scenes.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <unordered_set>
+
+//== IMPLEMENTATION ==========================================================
+
+bool setup_scene(MassSpringSystem& body, int scene)
+{
+    if (scene < 1 || scene > n_scenes)
+        return false;
+
+    // all scenes are enclosed by the walls of the box [-1,1]^2
+    body.obstacles_.clear();
+    body.obstacles_.add_walls(vec2(-1, -1), vec2(1, 1));
+
+    switch (scene)
+    {
+        // problem 1: a single particle
+        case 1:
+        {
+            body.clear(1, 0, 0);
+            body.add_particle(vec2(-0.8, -0.8), vec2(5.0, 5.0), false);
+            break;
+        }
+
+        // problem 2: a triangle
+        case 2:
+        {
+            body.clear(3, 3, 1);
+            body.add_particle(vec2(-0.1, 0.7), vec2(0.0, 0.0), false);
+            body.add_particle(vec2(0.0, 0.6), vec2(0.0, 0.0), false);
+            body.add_particle(vec2(0.1, 0.7), vec2(0.0, 0.0), false);
+            body.add_spring(0, 1);
+            body.add_spring(0, 2);
+            body.add_spring(1, 2);
+            body.add_triangle(0, 1, 2);
+            break;
+        }
+
+        // problem 3: a wheel
+        case 3:
+        {
+            body.clear(9, 16, 8);
+            for (int i = 0; i < 8; ++i)
+            {
+                body.add_particle(vec2(-0.5 + 0.2 * cos(0.25 * i * M_PI),
+                                       -0.5 + 0.2 * sin(0.25 * i * M_PI)),
+                                  vec2(5.0, 5.0), false);
+            }
+            body.add_particle(vec2(-0.5, -0.5), vec2(5.0, 5.0), false);
+            for (unsigned int i = 0; i < 8; ++i)
+            {
+                body.add_spring(i, (i + 1) % 8);
+                body.add_spring(i, 8);
+                body.add_triangle(i, (i + 1) % 8, 8);
+            }
+            break;
+        }
+
+        // problem 4: a chain with a locked end
+        case 4:
+        {
+            body.clear(10, 9, 0);
+            for (int i = 0; i < 10; ++i)
+            {
+                body.add_particle(vec2(i * 0.1, 0.8), vec2(0.0, 0.0), i == 0);
+            }
+            for (unsigned int i = 0; i < 9; ++i)
+            {
+                body.add_spring(i, i + 1);
+            }
+            break;
+        }
+
+        // a cloth falling onto a disc and a ramp
+        case 5:
+        {
+            body.obstacles_.add_circle(vec2(-0.3, -0.1), 0.2);
+            body.obstacles_.add_polygon(
+                {vec2(0.1, -1.0), vec2(1.0, -1.0), vec2(1.0, -0.3)});
+
+            const int n = 12;
+            body.clear(n * n, 3 * n * n, 2 * n * n);
+            for (int j = 0; j < n; ++j)
+            {
+                for (int i = 0; i < n; ++i)
+                {
+                    body.add_particle(vec2(-0.6 + 0.06 * i, 0.8 - 0.06 * j),
+                                      vec2(0.0, 0.0), false);
+                }
+            }
+            for (int j = 0; j < n; ++j)
+            {
+                for (int i = 0; i < n; ++i)
+                {
+                    const unsigned int k = j * n + i;
+                    if (i + 1 < n)
+                        body.add_spring(k, k + 1);
+                    if (j + 1 < n)
+                        body.add_spring(k, k + n);
+                    if (i + 1 < n && j + 1 < n)
+                    {
+                        body.add_spring(k, k + n + 1);
+                        body.add_triangle(k, k + n + 1, k + n);
+                        body.add_triangle(k, k + 1, k + n + 1);
+                    }
+                }
+            }
+            break;
+        }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+// add the polygon `face` to `triangles` as a triangle fan
+static void add_face(const std::vector<long>& face, size_t n_vertices,
+                     std::vector<unsigned int>& triangles)
+{
+    for (long i : face)
+        if (i < 0 || i >= (long)n_vertices)
+            return;
+
+    for (size_t i = 2; i < face.size(); ++i)
+    {
+        triangles.push_back(face[0]);
+        triangles.push_back(face[i - 1]);
+        triangles.push_back(face[i]);
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+// read vertices and (triangulated) faces of an OBJ file
+static bool read_obj(std::ifstream& ifs, std::vector<vec2>& vertices,
+                     std::vector<unsigned int>& triangles)
+{
+    std::string line;
+    std::vector<long> face;
+    while (std::getline(ifs, line))
+    {
+        const char* c = line.c_str();
+        while (*c == ' ' || *c == '\t')
+            ++c;
+
+        // vertex: v x y [z]
+        if (c[0] == 'v' && (c[1] == ' ' || c[1] == '\t'))
+        {
+            char* end;
+            float x = strtof(c + 1, &end);
+            float y = strtof(end, &end);
+            vertices.push_back(vec2(x, y));
+        }
+
+        // face: f v0 v1 v2 ..., each vertex as v, v/vt, v//vn, or v/vt/vn.
+        // indices start at 1, negative indices are relative to the end.
+        else if (c[0] == 'f' && (c[1] == ' ' || c[1] == '\t'))
+        {
+            face.clear();
+            char* end = const_cast<char*>(c + 1);
+            for (;;)
+            {
+                const char* begin = end;
+                long i = strtol(begin, &end, 10);
+                if (end == begin)
+                    break;
+                face.push_back(i < 0 ? (long)vertices.size() + i : i - 1);
+                while (*end && *end != ' ' && *end != '\t')
+                    ++end;
+            }
+            add_face(face, vertices.size(), triangles);
+        }
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+// read vertices and (triangulated) faces of an OFF file
+static bool read_off(std::ifstream& ifs, std::vector<vec2>& vertices,
+                     std::vector<unsigned int>& triangles)
+{
+    // the counts of the header are not trusted for reserving memory, the
+    // size of the file bounds the number of vertices and faces
+    const std::streamoff begin = ifs.tellg();
+    ifs.seekg(0, std::ios::end);
+    const long n_bytes = std::max<long>(ifs.tellg() - begin, 0);
+    ifs.seekg(begin);
+
+    // the header keyword, then the counts (comments start with #)
+    std::string word;
+    ifs >> word;
+    if (word.compare(0, 3, "OFF") != 0)
+        return false;
+
+    long n_vertices = -1, n_faces = -1, n_edges = -1;
+    while (ifs >> word)
+    {
+        if (word[0] == '#')
+        {
+            ifs.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            continue;
+        }
+        n_vertices = strtol(word.c_str(), nullptr, 10);
+        ifs >> n_faces >> n_edges;
+        break;
+    }
+    if (!ifs || n_vertices < 0 || n_faces < 0)
+        return false;
+
+    // vertices: x y z, each line has at least 6 characters
+    std::string line;
+    std::getline(ifs, line);
+    vertices.reserve(std::min(n_vertices, n_bytes / 6));
+    while ((long)vertices.size() < n_vertices && std::getline(ifs, line))
+    {
+        char* end;
+        float x = strtof(line.c_str(), &end);
+        if (end == line.c_str())
+            continue; // empty line or comment
+        float y = strtof(end, &end);
+        vertices.push_back(vec2(x, y));
+    }
+
+    // faces: n v0 ... vn-1 (indices start at 0), each line has at least 8
+    // characters. a face cannot have more corners than there are vertices.
+    std::vector<long> face;
+    triangles.reserve(3 * std::min(n_faces, n_bytes / 8));
+    for (long f = 0; f < n_faces && std::getline(ifs, line);)
+    {
+        char* end;
+        long n = strtol(line.c_str(), &end, 10);
+        if (end == line.c_str())
+            continue;
+        if (n < 0 || n > (long)vertices.size())
+            return false;
+        face.clear();
+        for (long i = 0; i < n; ++i)
+        {
+            const char* begin = end;
+            face.push_back(strtol(begin, &end, 10));
+            if (end == begin)
+                return false;
+        }
+        add_face(face, vertices.size(), triangles);
+        ++f;
+    }
+
+    return (long)vertices.size() == n_vertices;
+}
+
+//-----------------------------------------------------------------------------
+
+bool load_scene(MassSpringSystem& body, const std::string& filename)
+{
+    std::ifstream ifs(filename);
+    if (!ifs)
+    {
+        std::cerr << "load_scene: cannot open " << filename << std::endl;
+        return false;
+    }
+
+    std::string ext = filename.substr(filename.find_last_of('.') + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+    std::vector<vec2> vertices;
+    std::vector<unsigned int> triangles;
+    bool ok = false;
+    if (ext == "obj")
+        ok = read_obj(ifs, vertices, triangles);
+    else if (ext == "off")
+        ok = read_off(ifs, vertices, triangles);
+    if (!ok || vertices.empty())
+    {
+        std::cerr << "load_scene: cannot read " << filename << std::endl;
+        return false;
+    }
+
+    // fit the bounding box into the upper part of the simulation box
+    vec2 bb_min(FLT_MAX, FLT_MAX), bb_max(-FLT_MAX, -FLT_MAX);
+    for (const vec2& x : vertices)
+    {
+        bb_min = min(bb_min, x);
+        bb_max = max(bb_max, x);
+    }
+    const float extent = std::max(bb_max[0] - bb_min[0], bb_max[1] - bb_min[1]);
+    const float scale = extent > 0.0f ? 1.6f / extent : 1.0f;
+    const vec2 center = 0.5f * (bb_min + bb_max);
+    const vec2 offset(0.0f, 0.9f - 0.5f * scale * (bb_max[1] - bb_min[1]));
+    for (vec2& x : vertices)
+        x = scale * (x - center) + offset;
+
+    // one spring per edge. interior edges are shared by two faces, so they
+    // are deduplicated with a hash set of (smaller, larger) index pairs.
+    std::vector<unsigned int> springs;
+    std::unordered_set<uint64_t> edges;
+    edges.reserve(triangles.size());
+    springs.reserve(triangles.size());
+    for (size_t t = 0; t < triangles.size(); t += 3)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            unsigned int i = triangles[t + k];
+            unsigned int j = triangles[t + (k + 1) % 3];
+            if (i > j)
+                std::swap(i, j);
+            if (i != j && edges.insert((uint64_t(i) << 32) | j).second)
+            {
+                springs.push_back(i);
+                springs.push_back(j);
+            }
+        }
+    }
+
+    body.obstacles_.clear();
+    body.obstacles_.add_walls(vec2(-1, -1), vec2(1, 1));
+    body.clear(vertices.size(), springs.size() / 2, triangles.size() / 3);
+    body.add_elements(vertices, springs, triangles);
+
+    return true;
+}
+
+//=============================================================================
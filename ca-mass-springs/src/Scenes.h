@@ -0,0 +1,33 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+#pragma once
+//=============================================================================
+
+#include "MassSpringSystem.h"
+
+#include <string>
+
+//=============================================================================
+
+/// number of built-in scenes
+const int n_scenes = 5;
+
+/// replace the content of `body` by the built-in scene `scene` (1 to
+/// n_scenes). returns false for an invalid scene number.
+bool setup_scene(MassSpringSystem& body, int scene);
+
+/// replace the content of `body` by the 2D triangle mesh in `filename`
+/// (OBJ or OFF, z coordinates are ignored). each vertex becomes a particle,
+/// each face a triangle (polygons are fan-triangulated), and each edge a
+/// spring. the mesh is scaled to fit into the simulation box.
+/// returns false if the file cannot be read.
+bool load_scene(MassSpringSystem& body, const std::string& filename);
+
+//=============================================================================
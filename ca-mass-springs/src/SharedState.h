@@ -0,0 +1,124 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+#pragma once
+//=============================================================================
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//== CLASS DEFINITION =========================================================
+
+/** \class SharedState SharedState.h
+ Publishes simulation frames to other processes through a POSIX shared
+ memory segment (Linux and macOS only). The segment holds a ring of slots,
+ each slot one frame of `count` elements with `components` floats each
+ (e.g. particle positions).
+
+ Every slot is protected by a seqlock: the writer makes the sequence number
+ odd, writes the frame, and makes it even again. It never waits for readers,
+ so publishing costs no more than writing the frame. Readers copy the latest
+ slot and retry if its sequence number was odd or has changed meanwhile.
+
+ If a frame exceeds the capacity of the segment, the writer marks the
+ segment as closed and replaces it by a larger one, readers then have to
+ attach again.
+ */
+class SharedState
+{
+public:
+    /// a frame copied by a reader
+    struct Frame
+    {
+        Frame() : number(0), time(0.0), count(0) {}
+
+        uint64_t number;         ///< frame number, starting at 1
+        double time;             ///< simulation time
+        uint64_t count;          ///< number of elements
+        std::vector<float> data; ///< count * components floats
+    };
+
+    SharedState();
+    ~SharedState();
+
+    /// writer: create segment `name` (e.g. "/mass_springs") for frames of up
+    /// to `capacity` elements of `components` floats each
+    bool create(const std::string& name, size_t capacity,
+                unsigned int components, unsigned int n_slots = 4);
+
+    /// reader: attach to the existing segment `name`
+    bool attach(const std::string& name);
+
+    /// unmap the segment, the writer also marks it as closed and removes it
+    void close();
+
+    /// is a segment mapped?
+    bool is_open() const { return header_ != nullptr; }
+
+    /// name of the mapped segment
+    const std::string& name() const { return name_; }
+
+    /// number of floats per element
+    unsigned int components() const;
+
+    /// writer: start the next frame of `count` elements and return where to
+    /// write its count * components floats (nullptr if no segment is open)
+    float* begin_frame(size_t count);
+
+    /// writer: finish the frame started by begin_frame() and publish it
+    void end_frame(double time);
+
+    /// reader: copy the latest frame if it is newer than `frame.number`.
+    /// returns false if there is no new frame, or if no consistent copy
+    /// succeeded within a bounded number of attempts (poll again later).
+    bool read(Frame& frame) const;
+
+    /// reader: has the writer closed the segment?
+    bool is_closed() const;
+
+private:
+    /// beginning of the segment
+    struct Header
+    {
+        uint32_t magic;                 ///< identifies the segment
+        uint32_t n_slots;               ///< number of slots
+        uint32_t components;            ///< floats per element
+        uint32_t slot_size;             ///< bytes per slot
+        uint64_t capacity;              ///< max. elements per frame
+        std::atomic<uint64_t> frame;    ///< number of the latest frame
+        std::atomic<uint32_t> closed;   ///< segment has been replaced
+    };
+
+    /// beginning of a slot, followed by the frame's data
+    struct Slot
+    {
+        std::atomic<uint32_t> sequence; ///< odd while being written
+        uint32_t unused;
+        uint64_t number;                ///< frame number
+        double time;                    ///< simulation time
+        uint64_t count;                 ///< number of elements
+    };
+
+    /// map `bytes` of the segment opened as file `fd`
+    bool map(int fd, size_t bytes, bool writable);
+
+    /// slot of frame `number`
+    Slot* slot(uint64_t number) const;
+
+    std::string name_;  ///< name of the segment
+    Header* header_;    ///< mapped segment
+    size_t bytes_;      ///< size of the mapping
+    bool writer_;       ///< did we create the segment?
+    uint64_t frame_;    ///< number of the frame being written
+};
+
+//=============================================================================
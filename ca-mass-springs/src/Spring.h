@@ -21,7 +21,8 @@ class Spring
 {
 public:
     /// construct with two particles. automatically computes rest length.
-    Spring(Particle &p0, Particle &p1) : particle0(p0), particle1(p1)
+    Spring(Particle &p0, Particle &p1)
+        : particle0(p0), particle1(p1), dead(false)
     {
         rest_length = length();
     }
@@ -35,6 +36,7 @@ public:
     Particle &particle0; ///< reference of first particle
     Particle &particle1; ///< reference of second particle
     float rest_length;   ///< rest length
+    bool dead;           ///< torn? dead springs are skipped until compaction
 };
 
 //=============================================================================
@@ -0,0 +1,251 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+
+#include "Trajectories.h"
+#include "MassSpringSystem.h"
+#include "Scenes.h"
+
+#include <pmp/Timer.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+
+//== IMPLEMENTATION ==========================================================
+
+// scenes whose reference took less time are too short for timing checks
+static const double min_timing_seconds = 0.01;
+
+//-----------------------------------------------------------------------------
+
+Trajectories::Trajectories(int steps, int sample_interval)
+    : steps(steps), sample_interval(sample_interval)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+void Trajectories::simulate()
+{
+    cases.clear();
+    for (int scene = 1; scene <= n_scenes; ++scene)
+    {
+        for (int integration = 0; integration < 4; ++integration)
+        {
+            for (int collisions = 0; collisions < 3; ++collisions)
+            {
+                MassSpringSystem body(false);
+                setup_scene(body, scene);
+                body.integration_ =
+                    decltype(body.integration_)(integration);
+                body.collisions_ = decltype(body.collisions_)(collisions);
+
+                Case c;
+                c.scene = scene;
+                c.integration = integration;
+                c.collisions = collisions;
+                c.n_particles = body.particles.size();
+
+                pmp::Timer timer;
+                for (int step = 1; step <= steps; ++step)
+                {
+                    timer.cont();
+                    body.time_integration();
+                    timer.stop();
+
+                    if (step % sample_interval == 0)
+                    {
+                        for (const Particle& p : body.particles)
+                        {
+                            c.samples.push_back(p.position[0]);
+                            c.samples.push_back(p.position[1]);
+                        }
+                    }
+                }
+                c.seconds = timer.elapsed() / 1000.0;
+
+                cases.push_back(c);
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+bool Trajectories::read(const std::string& filename)
+{
+    std::ifstream ifs(filename);
+    std::string header;
+    size_t n_cases;
+    if (!(ifs >> header >> steps >> sample_interval >> n_cases) ||
+        header != "trajectories")
+    {
+        std::cerr << "Trajectories: cannot read " << filename << std::endl;
+        return false;
+    }
+
+    // numbers are read as strings, since streams do not parse nan and inf
+    cases.resize(n_cases);
+    for (Case& c : cases)
+    {
+        size_t n_samples;
+        ifs >> c.scene >> c.integration >> c.collisions >> c.n_particles >>
+            c.seconds >> n_samples;
+        c.samples.resize(n_samples);
+        std::string value;
+        for (float& s : c.samples)
+        {
+            ifs >> value;
+            s = std::strtof(value.c_str(), nullptr);
+        }
+    }
+
+    if (!ifs)
+    {
+        std::cerr << "Trajectories: cannot read " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool Trajectories::write(const std::string& filename) const
+{
+    std::ofstream ofs(filename);
+    if (!ofs)
+    {
+        std::cerr << "Trajectories: cannot write " << filename << std::endl;
+        return false;
+    }
+
+    // enough digits to read back the same floats
+    ofs.precision(9);
+    ofs << "trajectories " << steps << " " << sample_interval << " "
+        << cases.size() << "\n";
+    for (const Case& c : cases)
+    {
+        ofs << c.scene << " " << c.integration << " " << c.collisions << " "
+            << c.n_particles << " " << c.seconds << " " << c.samples.size();
+        for (float s : c.samples)
+            ofs << " " << s;
+        ofs << "\n";
+    }
+
+    return bool(ofs);
+}
+
+//-----------------------------------------------------------------------------
+
+bool Trajectories::compare(const Trajectories& reference, float tolerance,
+                           float max_slowdown, std::ostream& os) const
+{
+    bool passed = true;
+    if (steps != reference.steps ||
+        sample_interval != reference.sample_interval)
+    {
+        os << "different number of steps or sample interval\n";
+        return false;
+    }
+
+    // accumulated time per scene, single cases are too short to be timed
+    std::map<int, double> seconds, reference_seconds;
+
+    for (const Case& r : reference.cases)
+    {
+        reference_seconds[r.scene] += r.seconds;
+
+        auto c = cases.begin();
+        while (c != cases.end() &&
+               (c->scene != r.scene || c->integration != r.integration ||
+                c->collisions != r.collisions))
+            ++c;
+
+        os << "scene " << r.scene << ", integration " << r.integration
+           << ", collisions " << r.collisions << ": ";
+        if (c == cases.end())
+        {
+            os << "FAILED (missing)\n";
+            passed = false;
+            continue;
+        }
+        seconds[c->scene] += c->seconds;
+
+        if (c->n_particles != r.n_particles ||
+            c->samples.size() != r.samples.size())
+        {
+            os << "FAILED (" << c->n_particles << " instead of "
+               << r.n_particles << " particles)\n";
+            passed = false;
+            continue;
+        }
+
+        // max. deviation of finite positions, blow-ups have to match
+        float deviation = 0.0;
+        bool blow_up = false, blow_up_mismatch = false;
+        for (size_t i = 0; i < r.samples.size(); ++i)
+        {
+            const bool finite = std::isfinite(r.samples[i]);
+            if (finite != std::isfinite(c->samples[i]))
+                blow_up_mismatch = true;
+            else if (finite)
+                deviation = std::max(
+                    deviation, std::fabs(c->samples[i] - r.samples[i]));
+            else
+                blow_up = true;
+        }
+
+        if (blow_up_mismatch)
+        {
+            os << "FAILED (blow-up differs)\n";
+            passed = false;
+        }
+        else if (deviation > tolerance)
+        {
+            os << "FAILED (deviation " << deviation << ")\n";
+            passed = false;
+        }
+        else
+        {
+            os << "ok (deviation " << deviation
+               << (blow_up ? ", blows up" : "") << ")\n";
+        }
+    }
+
+    // throughput of each scene
+    for (const auto& s : reference_seconds)
+    {
+        os << "scene " << s.first << ": " << 1000.0 * seconds[s.first]
+           << " ms (reference " << 1000.0 * s.second << " ms) ";
+        if (max_slowdown <= 0.0)
+        {
+            os << "not checked\n";
+        }
+        else if (s.second < min_timing_seconds)
+        {
+            os << "too short for timing\n";
+        }
+        else if (seconds[s.first] > max_slowdown * s.second)
+        {
+            os << "FAILED (too slow)\n";
+            passed = false;
+        }
+        else
+        {
+            os << "ok\n";
+        }
+    }
+
+    os << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed;
+}
+
+//=============================================================================
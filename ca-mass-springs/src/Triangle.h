@@ -22,7 +22,7 @@ class Triangle
 public:
     /// construct with three particles. automatically computes rest area.
     Triangle(Particle &p0, Particle &p1, Particle &p2)
-        : particle0(p0), particle1(p1), particle2(p2)
+        : particle0(p0), particle1(p1), particle2(p2), dead(false)
     {
         rest_area = area();
     }
@@ -41,6 +41,7 @@ public:
     Particle &particle1; ///< reference of second particle
     Particle &particle2; ///< reference of third particle
     float rest_area;     ///< area in rest state
+    bool dead;           ///< torn? dead triangles are skipped until compaction
 };
 
 //=============================================================================
@@ -11,6 +11,7 @@
 //== INCLUDES =================================================================
 
 #include <Viewer.h>
+#include <Scenes.h>
 #include <pmp/GL.h>
 #include <imgui.h>
 #include <chrono>
@@ -23,10 +24,12 @@ Viewer::Viewer(const char* _title, int _width, int _height)
     : Window(_title, _width, _height)
 {
     animate_ = false;
+    substeps_ = 20;
+    simulation_time_ = 0.0;
     keyboard('3', 0, GLFW_PRESS, 0);
 
     clear_help_items();
-    add_help_item("1-4", "Initialize different scenes");
+    add_help_item("1-5", "Initialize different scenes");
     add_help_item("Space", "Start/stop simulation");
     add_help_item("S", "Single time step");
     add_help_item("Left mouse", "Drag mass points");
@@ -40,6 +43,13 @@ Viewer::Viewer(const char* _title, int _width, int _height)
 
 //-----------------------------------------------------------------------------
 
+bool Viewer::load_mesh(const std::string& filename)
+{
+    return load_scene(body_, filename);
+}
+
+//-----------------------------------------------------------------------------
+
 void Viewer::keyboard(int key, int code, int action, int mods)
 {
     if (action != GLFW_PRESS && action != GLFW_REPEAT)
@@ -47,60 +57,14 @@ void Viewer::keyboard(int key, int code, int action, int mods)
 
     switch (key)
     {
-        // setup problem 1
+        // setup problems 1-4 and the obstacle scene 5
         case '1':
-        {
-            body_.clear();
-            body_.add_particle(vec2(-0.8, -0.8), vec2(5.0, 5.0), false);
-            break;
-        }
-
-        // setup problem 2
         case '2':
-        {
-            body_.clear();
-            body_.add_particle(vec2(-0.1, 0.7), vec2(0.0, 0.0), false);
-            body_.add_particle(vec2(0.0, 0.6), vec2(0.0, 0.0), false);
-            body_.add_particle(vec2(0.1, 0.7), vec2(0.0, 0.0), false);
-            body_.add_spring(0, 1);
-            body_.add_spring(0, 2);
-            body_.add_spring(1, 2);
-            body_.add_triangle(0, 1, 2);
-            break;
-        }
-
-        // setup problem 3
         case '3':
-        {
-            body_.clear();
-            for (int i = 0; i < 8; ++i)
-            {
-                body_.add_particle(vec2(-0.5 + 0.2 * cos(0.25 * i * M_PI),
-                                        -0.5 + 0.2 * sin(0.25 * i * M_PI)),
-                                   vec2(5.0, 5.0), false);
-            }
-            body_.add_particle(vec2(-0.5, -0.5), vec2(5.0, 5.0), false);
-            for (unsigned int i = 0; i < 8; ++i)
-            {
-                body_.add_spring(i, (i + 1) % 8);
-                body_.add_spring(i, 8);
-                body_.add_triangle(i, (i + 1) % 8, 8);
-            }
-            break;
-        }
-
-        // setup problem 4
         case '4':
+        case '5':
         {
-            body_.clear();
-            for (int i = 0; i < 10; ++i)
-            {
-                body_.add_particle(vec2(i * 0.1, 0.8), vec2(0.0, 0.0), i == 0);
-            }
-            for (unsigned int i = 0; i < 9; ++i)
-            {
-                body_.add_spring(i, i + 1);
-            }
+            setup_scene(body_, key - '0');
             break;
         }
 
@@ -148,13 +112,23 @@ void Viewer::do_processing()
                            current - before)
                            .count();
 
-        // let's do 20 time steps after 15ms (which is approximately 60Hz)
+        // let's do 20 time steps after 15ms (which is approximately 60Hz).
+        // with automatic time steps, the number of steps is chosen such that
+        // each frame advances the simulation by 10ms.
         if (elapsed > 15)
         {
-            for (int i = 0; i < 20; ++i)
+            if (body_.auto_time_step_)
+            {
+                body_.time_step_ = body_.stable_time_step();
+                substeps_ = body_.substeps(0.01);
+            }
+
+            for (int i = 0; i < substeps_; ++i)
             {
                 body_.time_integration();
             }
+            simulation_time_ += substeps_ * body_.time_step_;
+            publish_state();
 
             before = current;
         }
@@ -163,6 +137,22 @@ void Viewer::do_processing()
 
 //-----------------------------------------------------------------------------
 
+void Viewer::publish_state()
+{
+    float* data = shared_state_.begin_frame(body_.particles.size());
+    if (!data)
+        return;
+
+    for (const Particle& p : body_.particles)
+    {
+        *data++ = p.position[0];
+        *data++ = p.position[1];
+    }
+    shared_state_.end_frame(simulation_time_);
+}
+
+//-----------------------------------------------------------------------------
+
 void Viewer::process_imgui()
 {
     if (ImGui::CollapsingHeader("Time Integration",
@@ -175,6 +165,7 @@ void Viewer::process_imgui()
         ImGui::RadioButton("Euler", (int*)&body_.integration_, 0);
         ImGui::RadioButton("Midpoint", (int*)&body_.integration_, 1);
         ImGui::RadioButton("Verlet", (int*)&body_.integration_, 2);
+        ImGui::RadioButton("IMEX", (int*)&body_.integration_, 3);
 
         ImGui::Spacing();
         ImGui::Spacing();
@@ -183,8 +174,17 @@ void Viewer::process_imgui()
         ImGui::PushItemWidth(120);
         ImGui::SliderFloat("Time Step", &body_.time_step_, 0.00005f, 0.006f,
                            "%.5f", 2);
+        ImGui::SliderInt("Substeps", &substeps_, 1, 200);
         ImGui::PopItemWidth();
 
+        // automatic time step
+        if (ImGui::Checkbox("Auto Time Step", &body_.auto_time_step_) &&
+            !body_.auto_time_step_)
+        {
+            substeps_ = 20;
+        }
+        ImGui::Text("Stable time step: %.5f", body_.stable_time_step());
+
         ImGui::Spacing();
         ImGui::Spacing();
     }
@@ -212,11 +212,162 @@ void Viewer::process_imgui()
                            100000.0f, "%.0f", 3.5);
         ImGui::SliderFloat("Coll. Damping", &body_.collision_damping_, 0.0f,
                            1.0f, "%.2f", 1.5);
+        ImGui::SliderFloat("Tear Strain", &body_.tear_strain_, 0.0f, 2.0f,
+                           "%.2f", 2.0);
+        ImGui::PopItemWidth();
+
+        ImGui::Spacing();
+        ImGui::Spacing();
+    }
+
+    if (ImGui::CollapsingHeader("Performance"))
+    {
+        ImGui::PushItemWidth(120);
+        ImGui::SliderInt("Reorder Interval", &body_.reorder_interval_, 0,
+                         10000);
+        ImGui::PopItemWidth();
+        if (ImGui::Button("Reorder Particles"))
+        {
+            body_.reorder_particles();
+        }
+
+        ImGui::PushItemWidth(120);
+        ImGui::SliderInt("Compaction Interval", &body_.compaction_interval_, 0,
+                         1000);
+        ImGui::PopItemWidth();
+        ImGui::Text("Torn springs: %d, triangles: %d",
+                    body_.n_dead_springs(), body_.n_dead_triangles());
+
+        ImGui::Spacing();
+        ImGui::Checkbox("Sleeping", &body_.use_sleeping_);
+        ImGui::PushItemWidth(120);
+        ImGui::SliderFloat("Sleep Velocity", &body_.sleep_velocity_, 0.0f,
+                           0.2f, "%.3f", 2.0);
+        ImGui::SliderFloat("Sleep Time", &body_.sleep_time_, 0.0f, 5.0f,
+                           "%.2f");
         ImGui::PopItemWidth();
+        ImGui::Text("Sleeping particles: %d", body_.n_sleeping());
+
+        ImGui::Spacing();
+        ImGui::Spacing();
+    }
+
+    if (ImGui::CollapsingHeader("Diagnostics"))
+    {
+        ImGui::PushItemWidth(120);
+        ImGui::SliderInt("Sample Interval", &body_.diagnostics_interval_, 0,
+                         100);
+        ImGui::SliderFloat("Energy Growth Limit", &body_.energy_growth_limit_,
+                           0.0f, 10.0f, "%.1f");
+        ImGui::PopItemWidth();
+
+        // total energy of the last samples
+        const int n = body_.n_diagnostics();
+        if (n > 0)
+        {
+            auto total = [](void* data, int i) {
+                return (float)((MassSpringSystem*)data)->diagnostics(i).total();
+            };
+            ImGui::PlotLines("##Energy", total, &body_, n, 0, "total energy",
+                             FLT_MAX, FLT_MAX, ImVec2(0, 80));
+
+            const MassSpringSystem::Diagnostics& d = body_.diagnostics(n - 1);
+            ImGui::Text("Kinetic:       %.4f", d.kinetic);
+            ImGui::Text("Gravitational: %.4f", d.gravitational);
+            ImGui::Text("Spring:        %.4f", d.spring);
+            ImGui::Text("Area:          %.4f", d.area);
+            ImGui::Text("Collision:     %.4f", d.collision);
+            ImGui::Text("Momentum:      (%.3f, %.3f)", d.momentum[0],
+                        d.momentum[1]);
+        }
+        if (body_.n_time_step_reductions() > 0)
+            ImGui::Text("Time step lowered %u times on energy blow-up",
+                        body_.n_time_step_reductions());
+
+        ImGui::Spacing();
+        ImGui::Spacing();
+    }
+
+    if (ImGui::CollapsingHeader("Timings"))
+    {
+        ImGui::Checkbox("Measure Timings", &body_.profiler_.enabled);
+
+        // rolling statistics of the last steps, in milliseconds
+        ImGui::Columns(4, "timings", false);
+        ImGui::Text("Phase");
+        ImGui::NextColumn();
+        ImGui::Text("min");
+        ImGui::NextColumn();
+        ImGui::Text("avg");
+        ImGui::NextColumn();
+        ImGui::Text("p99");
+        ImGui::NextColumn();
+        for (const char* phase : body_.profiler_.phases())
+        {
+            Profiler::Statistics stats = body_.profiler_.statistics(phase);
+            ImGui::Text("%s", phase);
+            ImGui::NextColumn();
+            ImGui::Text("%.3f", stats.min);
+            ImGui::NextColumn();
+            ImGui::Text("%.3f", stats.avg);
+            ImGui::NextColumn();
+            ImGui::Text("%.3f", stats.p99);
+            ImGui::NextColumn();
+        }
+        ImGui::Columns(1);
+
+        ImGui::Spacing();
+
+        // record a trace for chrome://tracing or ui.perfetto.dev
+        if (!body_.profiler_.is_tracing())
+        {
+            if (ImGui::Button("Record Trace"))
+                body_.profiler_.start_trace();
+        }
+        else if (ImGui::Button("Stop Trace"))
+        {
+            body_.profiler_.stop_trace();
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Save Trace"))
+        {
+            body_.profiler_.write_trace("trace.json");
+        }
+        ImGui::Text("%d events recorded",
+                    (int)body_.profiler_.n_trace_events());
 
         ImGui::Spacing();
         ImGui::Spacing();
     }
+
+#ifndef __EMSCRIPTEN__
+    if (ImGui::CollapsingHeader("Shared Memory"))
+    {
+        // positions of each frame, for external visualizers (shm_reader)
+        bool publish = shared_state_.is_open();
+        if (ImGui::Checkbox("Publish Positions", &publish))
+        {
+            if (publish)
+                shared_state_.create("/mass_springs", body_.particles.size(),
+                                     2);
+            else
+                shared_state_.close();
+        }
+        if (shared_state_.is_open())
+        {
+            ImGui::Text("Segment: %s", shared_state_.name().c_str());
+        }
+
+        ImGui::Spacing();
+        ImGui::Spacing();
+    }
+#endif
+
+    // changed parameters may disturb resting particles
+    if (body_.n_sleeping() && ImGui::IsAnyItemActive())
+    {
+        body_.wake_up();
+    }
 }
 
 //-----------------------------------------------------------------------------
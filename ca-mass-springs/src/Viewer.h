@@ -11,6 +11,7 @@
 //=============================================================================
 
 #include "MassSpringSystem.h"
+#include "SharedState.h"
 
 #include <pmp/Window.h>
 #include <pmp/Shader.h>
@@ -34,6 +35,9 @@ public:
     /// constructor
     Viewer(const char* _title, int _width, int _height);
 
+    /// load a triangle mesh (OBJ or OFF) as scene
+    bool load_mesh(const std::string& filename);
+
 private: // GUI functions
     /// render the scene
     virtual void display() override;
@@ -56,6 +60,9 @@ private: // GUI functions
     /// pick a 2D point by mouse clicking
     vec2 pick(int _x, int _y);
 
+    /// publish the particle positions to shared memory (if enabled)
+    void publish_state();
+
 private: // simulation data and settings
     /// the mass spring system to be simulated
     MassSpringSystem body_;
@@ -63,6 +70,15 @@ private: // simulation data and settings
     /// is animation on/off?
     bool animate_;
 
+    /// number of time steps per rendered frame
+    int substeps_;
+
+    /// simulated time since the viewer has been started
+    double simulation_time_;
+
+    /// shared memory the particle positions are published to
+    SharedState shared_state_;
+
     /// OpenGL stuff
     mat4 projection_matrix_;
 };
@@ -9,12 +9,115 @@
 //=============================================================================
 
 #include "Viewer.h"
+#include "Ensemble.h"
+#include "FrameWriter.h"
+#include "Scenes.h"
+#include "Trajectories.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+//=============================================================================
+
+#ifndef __EMSCRIPTEN__
+// simulate a built-in scene (number) or a mesh (filename) headless and write
+// `n_frames` frames of 10ms (as shown by the viewer) as PNG images
+static int export_frames(const std::string& scene, int n_frames,
+                         const std::string& directory)
+{
+    MassSpringSystem body(false);
+    const int number = atoi(scene.c_str());
+    if (!(number ? setup_scene(body, number) : load_scene(body, scene)))
+    {
+        std::cerr << "Cannot setup scene " << scene << std::endl;
+        return 1;
+    }
+
+    Rasterizer rasterizer(1024, 1024);
+    FrameWriter writer(directory);
+    for (int frame = 0; frame < n_frames; ++frame)
+    {
+        body.rasterize(rasterizer);
+        writer.write(rasterizer);
+
+        int substeps = 20;
+        if (body.auto_time_step_)
+        {
+            body.time_step_ = body.stable_time_step();
+            substeps = body.substeps(0.01);
+        }
+        for (int i = 0; i < substeps; ++i)
+            body.time_integration();
+    }
+
+    if (body.n_time_step_reductions() > 0)
+        std::cerr << "Time step lowered " << body.n_time_step_reductions()
+                  << " times on energy blow-up" << std::endl;
+
+    if (!writer.finish())
+    {
+        std::cerr << "Cannot write frames to " << directory << std::endl;
+        return 1;
+    }
+    return 0;
+}
+#endif
 
 //=============================================================================
 
 int main(int argc, char **argv)
 {
+#ifndef __EMSCRIPTEN__
+    // headless parameter sweep:
+    // mass_springs --ensemble <parameters.csv> <results.csv> [threads]
+    if (argc >= 4 && std::string(argv[1]) == "--ensemble")
+    {
+        Ensemble ensemble;
+        if (!ensemble.read(argv[2]))
+            return 1;
+        ensemble.run(argc > 4 ? atoi(argv[4]) : 0);
+        return ensemble.write(argv[3]) ? 0 : 1;
+    }
+
+    // headless video export:
+    // mass_springs --export <scene number|mesh> <frames> <directory>
+    if (argc == 5 && std::string(argv[1]) == "--export")
+    {
+        return export_frames(argv[2], atoi(argv[3]), argv[4]);
+    }
+
+    // regression check against golden trajectories:
+    // mass_springs --record <trajectories.txt>
+    // mass_springs --check <trajectories.txt> [tolerance] [max. slowdown]
+    if (argc == 3 && std::string(argv[1]) == "--record")
+    {
+        Trajectories trajectories;
+        trajectories.simulate();
+        return trajectories.write(argv[2]) ? 0 : 1;
+    }
+    if (argc >= 3 && std::string(argv[1]) == "--check")
+    {
+        Trajectories reference;
+        if (!reference.read(argv[2]))
+            return 1;
+        Trajectories trajectories(reference.steps, reference.sample_interval);
+        trajectories.simulate();
+        const float tolerance = argc > 3 ? atof(argv[3]) : 1e-4;
+        const float max_slowdown = argc > 4 ? atof(argv[4]) : 1.5;
+        return trajectories.compare(reference, tolerance, max_slowdown,
+                                    std::cout)
+                   ? 0
+                   : 1;
+    }
+#endif
+
     Viewer viewer("Mass Springs", 1024, 768);
+
+    // optionally start with a triangle mesh: mass_springs <mesh.obj|off>
+    if (argc == 2 && !viewer.load_mesh(argv[1]))
+        return 1;
+
     return viewer.run();
 }
 
@@ -0,0 +1,93 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+
+// Reads the frames a running simulation publishes to shared memory and
+// prints a summary of each frame, for testing external visualizers:
+//
+//   shm_reader [segment] [number of frames]
+//
+// the segment defaults to /mass_springs (particle positions), the rigid-body
+// simulation publishes to /rigid_bodies. without a number of frames it runs
+// until interrupted.
+
+#include "SharedState.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+//=============================================================================
+
+int main(int argc, char** argv)
+{
+    const std::string name = argc > 1 ? argv[1] : "/mass_springs";
+    const long max_frames = argc > 2 ? atol(argv[2]) : 0;
+
+    typedef std::chrono::steady_clock clock;
+    SharedState state;
+    SharedState::Frame frame;
+    long n_frames = 0;
+    clock::time_point last = clock::now();
+
+    while (max_frames == 0 || n_frames < max_frames)
+    {
+        // (re-)attach when the writer has started or replaced the segment
+        if (!state.is_open() || state.is_closed())
+        {
+            if (!state.attach(name))
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                continue;
+            }
+            frame = SharedState::Frame();
+            printf("attached to %s (%u components)\n", name.c_str(),
+                   state.components());
+        }
+
+        if (!state.read(frame))
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+            continue;
+        }
+        ++n_frames;
+
+        // bounding box of the first two components (the positions)
+        const unsigned int c = state.components();
+        float bbmin[2] = {0, 0}, bbmax[2] = {0, 0};
+        for (size_t i = 0; i < frame.count && c >= 2; ++i)
+        {
+            for (int j = 0; j < 2; ++j)
+            {
+                const float x = frame.data[i * c + j];
+                bbmin[j] = i ? std::min(bbmin[j], x) : x;
+                bbmax[j] = i ? std::max(bbmax[j], x) : x;
+            }
+        }
+
+        const clock::time_point now = clock::now();
+        const double ms =
+            std::chrono::duration<double, std::milli>(now - last).count();
+        last = now;
+
+        printf("frame %llu  t=%.4f  %llu elements  bbox (%.3f,%.3f)-(%.3f,"
+               "%.3f)  %.1f ms\n",
+               (unsigned long long)frame.number, frame.time,
+               (unsigned long long)frame.count, bbmin[0], bbmin[1], bbmax[0],
+               bbmax[1], ms);
+        fflush(stdout);
+    }
+
+    return 0;
+}
+
+//=============================================================================
@@ -0,0 +1,513 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+
+#include "AABBTree.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+//== IMPLEMENTATION ==========================================================
+
+typedef AABBTree::Box Box;
+
+static Box merge(const Box& a, const Box& b)
+{
+    return Box{min(a.min, b.min), max(a.max, b.max)};
+}
+
+static float perimeter(const Box& b)
+{
+    return 2.0f * (b.max[0] - b.min[0] + b.max[1] - b.min[1]);
+}
+
+static bool overlap(const Box& a, const Box& b)
+{
+    return a.min[0] <= b.max[0] && b.min[0] <= a.max[0] &&
+           a.min[1] <= b.max[1] && b.min[1] <= a.max[1];
+}
+
+static bool contains(const Box& outer, const Box& inner)
+{
+    return outer.min[0] <= inner.min[0] && outer.min[1] <= inner.min[1] &&
+           inner.max[0] <= outer.max[0] && inner.max[1] <= outer.max[1];
+}
+
+static bool contains(const Box& b, const vec2& p)
+{
+    return b.min[0] <= p[0] && p[0] <= b.max[0] && b.min[1] <= p[1] &&
+           p[1] <= b.max[1];
+}
+
+// squared distance of point `p` to box `b` (0 inside)
+static float sqr_distance(const Box& b, const vec2& p)
+{
+    const vec2 d = max(max(b.min - p, p - b.max), vec2(0, 0));
+    return dot(d, d);
+}
+
+// does the segment from `from` with direction `d` (t in [0,1]) hit `b`?
+static bool hit(const Box& b, const vec2& from, const vec2& d)
+{
+    float t0 = 0.0, t1 = 1.0;
+    for (int i = 0; i < 2; ++i)
+    {
+        if (d[i] == 0.0f)
+        {
+            if (from[i] < b.min[i] || from[i] > b.max[i])
+                return false;
+            continue;
+        }
+        float ta = (b.min[i] - from[i]) / d[i];
+        float tb = (b.max[i] - from[i]) / d[i];
+        if (ta > tb)
+            std::swap(ta, tb);
+        t0 = std::max(t0, ta);
+        t1 = std::min(t1, tb);
+        if (t0 > t1)
+            return false;
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+AABBTree::AABBTree(float margin) : margin_(margin), root_(-1), free_list_(-1)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+void AABBTree::clear()
+{
+    nodes_.clear();
+    root_ = free_list_ = -1;
+    leaves_.clear();
+    boxes_.clear();
+    pairs_.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+void AABBTree::update(const std::vector<RigidBody>& bodies)
+{
+    const int n = bodies.size();
+
+    // bodies have been added or removed: build from scratch
+    if ((int)leaves_.size() != n)
+    {
+        clear();
+        leaves_.resize(n, -1);
+    }
+
+    boxes_.resize(n);
+    for (int i = 0; i < n; ++i)
+    {
+        const RigidBody& b = bodies[i];
+
+        // sleeping bodies do not move, they stay where they are
+        int& leaf = leaves_[i];
+        if (b.sleeping && leaf >= 0)
+            continue;
+
+        Box& box = boxes_[i];
+        box.min = b.box_min;
+        box.max = b.box_max;
+
+        // still inside the fat box: nothing to do
+        if (leaf >= 0 && contains(nodes_[leaf].box, box))
+            continue;
+
+        if (leaf >= 0)
+            remove_leaf(leaf);
+        else
+            leaf = allocate_node();
+
+        const vec2 m(margin_ * b.radius, margin_ * b.radius);
+        Node& node = nodes_[leaf];
+        node.box = Box{box.min - m, box.max + m};
+        node.child[0] = node.child[1] = -1;
+        node.body = i;
+        node.height = 0;
+        insert_leaf(leaf);
+    }
+
+    // mark the subtrees with awake bodies, find_pairs() skips the others
+    for (Node& node : nodes_)
+        node.awake = false;
+    for (int i = 0; i < n; ++i)
+        if (!bodies[i].sleeping)
+            for (int node = leaves_[i]; node >= 0 && !nodes_[node].awake;
+                 node = nodes_[node].parent)
+                nodes_[node].awake = true;
+}
+
+//-----------------------------------------------------------------------------
+
+void AABBTree::find_pairs()
+{
+    pairs_.clear();
+    if (root_ < 0)
+        return;
+
+    // descend the tree against itself: a subtree is tested against itself
+    // (a == b) and pairs of subtrees only if their boxes overlap. subtrees
+    // of sleeping bodies are not tested against each other.
+    pair_stack_.assign(1, Pair(root_, root_));
+    while (!pair_stack_.empty())
+    {
+        const int a = pair_stack_.back().first, b = pair_stack_.back().second;
+        pair_stack_.pop_back();
+        const Node& A = nodes_[a];
+        const Node& B = nodes_[b];
+
+        if (!A.awake && !B.awake)
+        {
+            continue;
+        }
+        else if (a == b)
+        {
+            if (!A.is_leaf())
+            {
+                pair_stack_.push_back(Pair(A.child[0], A.child[0]));
+                pair_stack_.push_back(Pair(A.child[1], A.child[1]));
+                pair_stack_.push_back(Pair(A.child[0], A.child[1]));
+            }
+        }
+        else if (overlap(A.box, B.box))
+        {
+            if (A.is_leaf() && B.is_leaf())
+            {
+                // fat boxes overlap, report only overlapping tight boxes
+                if (overlap(boxes_[A.body], boxes_[B.body]))
+                    pairs_.push_back(std::minmax(A.body, B.body));
+            }
+            else if (B.is_leaf() ||
+                     (!A.is_leaf() && A.height >= B.height))
+            {
+                pair_stack_.push_back(Pair(A.child[0], b));
+                pair_stack_.push_back(Pair(A.child[1], b));
+            }
+            else
+            {
+                pair_stack_.push_back(Pair(a, B.child[0]));
+                pair_stack_.push_back(Pair(a, B.child[1]));
+            }
+        }
+    }
+
+    // same order as testing all pairs, collision response depends on it
+    std::sort(pairs_.begin(), pairs_.end());
+}
+
+//-----------------------------------------------------------------------------
+
+void AABBTree::query(const vec2& p, std::vector<int>& bodies) const
+{
+    bodies.clear();
+    if (root_ < 0)
+        return;
+
+    stack_.assign(1, root_);
+    while (!stack_.empty())
+    {
+        const Node& node = nodes_[stack_.back()];
+        stack_.pop_back();
+        if (!contains(node.box, p))
+            continue;
+
+        if (node.is_leaf())
+        {
+            if (contains(boxes_[node.body], p))
+                bodies.push_back(node.body);
+        }
+        else
+        {
+            stack_.push_back(node.child[0]);
+            stack_.push_back(node.child[1]);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void AABBTree::ray_cast(const vec2& from, const vec2& to,
+                        std::vector<int>& bodies) const
+{
+    bodies.clear();
+    if (root_ < 0)
+        return;
+
+    const vec2 d = to - from;
+    stack_.assign(1, root_);
+    while (!stack_.empty())
+    {
+        const Node& node = nodes_[stack_.back()];
+        stack_.pop_back();
+        if (!hit(node.box, from, d))
+            continue;
+
+        if (node.is_leaf())
+        {
+            if (hit(boxes_[node.body], from, d))
+                bodies.push_back(node.body);
+        }
+        else
+        {
+            stack_.push_back(node.child[0]);
+            stack_.push_back(node.child[1]);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+bool AABBTree::closest_point(const std::vector<RigidBody>& bodies,
+                             const vec2& p, int& body, int& point) const
+{
+    body = point = -1;
+    if (root_ < 0)
+        return false;
+
+    // skip subtrees farther away than the closest point found so far
+    float dmin = FLT_MAX;
+    stack_.assign(1, root_);
+    while (!stack_.empty())
+    {
+        const Node& node = nodes_[stack_.back()];
+        stack_.pop_back();
+        if (sqr_distance(node.box, p) >= dmin)
+            continue;
+
+        if (node.is_leaf())
+        {
+            const VertexRange<vec2>& points = bodies[node.body].points;
+            for (size_t i = 0; i < points.size(); ++i)
+            {
+                const float d = sqrnorm(points[i] - p);
+                if (d < dmin)
+                {
+                    dmin = d;
+                    body = node.body;
+                    point = i;
+                }
+            }
+        }
+        else
+        {
+            // visit the closer child first (it is on top of the stack)
+            const int c0 = node.child[0], c1 = node.child[1];
+            const bool swap = sqr_distance(nodes_[c0].box, p) <
+                              sqr_distance(nodes_[c1].box, p);
+            stack_.push_back(swap ? c1 : c0);
+            stack_.push_back(swap ? c0 : c1);
+        }
+    }
+
+    return body >= 0;
+}
+
+//-----------------------------------------------------------------------------
+
+int AABBTree::allocate_node()
+{
+    if (free_list_ < 0)
+    {
+        nodes_.push_back(Node());
+        nodes_.back().height = -1;
+        free_list_ = nodes_.size() - 1;
+        nodes_.back().parent = -1;
+    }
+
+    const int node = free_list_;
+    free_list_ = nodes_[node].parent;
+    nodes_[node].parent = -1;
+    nodes_[node].child[0] = nodes_[node].child[1] = -1;
+    nodes_[node].body = -1;
+    nodes_[node].height = 0;
+    return node;
+}
+
+//-----------------------------------------------------------------------------
+
+void AABBTree::free_node(int node)
+{
+    nodes_[node].parent = free_list_;
+    nodes_[node].height = -1;
+    free_list_ = node;
+}
+
+//-----------------------------------------------------------------------------
+
+void AABBTree::insert_leaf(int leaf)
+{
+    if (root_ < 0)
+    {
+        root_ = leaf;
+        nodes_[leaf].parent = -1;
+        return;
+    }
+
+    // descend to the sibling that increases the total perimeter the least
+    const Box box = nodes_[leaf].box;
+    int sibling = root_;
+    while (!nodes_[sibling].is_leaf())
+    {
+        const Node& node = nodes_[sibling];
+        const float area = perimeter(node.box);
+        const float combined = perimeter(merge(node.box, box));
+
+        // cost of a new parent here, and the increase for all ancestors
+        const float cost = 2.0f * combined;
+        const float inheritance = 2.0f * (combined - area);
+
+        float child_cost[2];
+        for (int k = 0; k < 2; ++k)
+        {
+            const Node& child = nodes_[node.child[k]];
+            child_cost[k] = perimeter(merge(child.box, box)) + inheritance;
+            if (!child.is_leaf())
+                child_cost[k] -= perimeter(child.box);
+        }
+
+        if (cost < child_cost[0] && cost < child_cost[1])
+            break;
+        sibling = node.child[child_cost[0] < child_cost[1] ? 0 : 1];
+    }
+
+    // new parent of sibling and leaf
+    const int old_parent = nodes_[sibling].parent;
+    const int parent = allocate_node();
+    Node& p = nodes_[parent];
+    p.parent = old_parent;
+    p.box = merge(box, nodes_[sibling].box);
+    p.height = nodes_[sibling].height + 1;
+    p.child[0] = sibling;
+    p.child[1] = leaf;
+    nodes_[sibling].parent = parent;
+    nodes_[leaf].parent = parent;
+
+    if (old_parent < 0)
+    {
+        root_ = parent;
+    }
+    else
+    {
+        Node& op = nodes_[old_parent];
+        op.child[op.child[0] == sibling ? 0 : 1] = parent;
+        refit(old_parent);
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void AABBTree::remove_leaf(int leaf)
+{
+    if (leaf == root_)
+    {
+        root_ = -1;
+        return;
+    }
+
+    const int parent = nodes_[leaf].parent;
+    const int grandparent = nodes_[parent].parent;
+    const Node& p = nodes_[parent];
+    const int sibling = p.child[p.child[0] == leaf ? 1 : 0];
+
+    // replace the parent by the sibling
+    if (grandparent < 0)
+    {
+        root_ = sibling;
+        nodes_[sibling].parent = -1;
+    }
+    else
+    {
+        Node& gp = nodes_[grandparent];
+        gp.child[gp.child[0] == parent ? 0 : 1] = sibling;
+        nodes_[sibling].parent = grandparent;
+        refit(grandparent);
+    }
+    free_node(parent);
+}
+
+//-----------------------------------------------------------------------------
+
+void AABBTree::refit(int node)
+{
+    while (node >= 0)
+    {
+        node = balance(node);
+
+        Node& n = nodes_[node];
+        const Node& c0 = nodes_[n.child[0]];
+        const Node& c1 = nodes_[n.child[1]];
+        n.box = merge(c0.box, c1.box);
+        n.height = 1 + std::max(c0.height, c1.height);
+
+        node = n.parent;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+int AABBTree::balance(int a)
+{
+    // a is an inner node with children b and c. if one child is two levels
+    // higher than the other, it is rotated up and its higher child stays
+    // below it, while its lower child takes its former place below a.
+    Node& A = nodes_[a];
+    if (A.height < 2)
+        return a;
+
+    const int b = A.child[0], c = A.child[1];
+    const int balance = nodes_[c].height - nodes_[b].height;
+    if (balance >= -1 && balance <= 1)
+        return a;
+
+    // the higher child x (= b or c) becomes the parent of a
+    const int x = balance > 1 ? c : b;
+    const int y = balance > 1 ? b : c;
+    const int ax = balance > 1 ? 1 : 0; // slot of x in a
+    Node& X = nodes_[x];
+    const int f = X.child[0], g = X.child[1];
+
+    // x takes the place of a
+    X.child[0] = a;
+    X.parent = A.parent;
+    A.parent = x;
+    if (X.parent < 0)
+    {
+        root_ = x;
+    }
+    else
+    {
+        Node& P = nodes_[X.parent];
+        P.child[P.child[0] == a ? 0 : 1] = x;
+    }
+
+    // the higher grandchild stays below x, the lower one moves to a
+    const bool f_higher = nodes_[f].height > nodes_[g].height;
+    const int keep = f_higher ? f : g;
+    const int move = f_higher ? g : f;
+    X.child[1] = keep;
+    A.child[ax] = move;
+    nodes_[move].parent = a;
+
+    const Node& Y = nodes_[y];
+    const Node& M = nodes_[move];
+    A.box = merge(Y.box, M.box);
+    A.height = 1 + std::max(Y.height, M.height);
+    X.box = merge(A.box, nodes_[keep].box);
+    X.height = 1 + std::max(A.height, nodes_[keep].height);
+
+    return x;
+}
+
+//=============================================================================
@@ -0,0 +1,122 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+#pragma once
+//=============================================================================
+
+#include "RigidBody.h"
+
+#include <utility>
+#include <vector>
+
+//== CLASS DEFINITION =========================================================
+
+/** \class AABBTree AABBTree.h
+ Dynamic bounding volume tree over the rigid bodies, an alternative
+ broadphase to SweepAndPrune for scenes with very different body sizes. Each
+ leaf stores a fattened bounding box of one body (enlarged by a margin
+ relative to the body radius). A body is only removed and reinserted when it
+ leaves its fat box; insertion descends to the sibling of least perimeter
+ increase, and rotations keep the tree balanced.
+
+ Besides the overlapping pairs, the tree answers point queries, segment
+ (ray) casts and closest-point queries, e.g. for picking with the mouse.
+ */
+class AABBTree
+{
+public:
+    /// a pair of body indices (first < second)
+    typedef std::pair<int, int> Pair;
+
+    /// axis-aligned bounding box
+    struct Box
+    {
+        vec2 min; ///< lower bounds
+        vec2 max; ///< upper bounds
+    };
+
+    /// constructor. fat boxes are enlarged by `margin` times the body radius.
+    explicit AABBTree(float margin = 0.2);
+
+    /// update the boxes of `bodies` and reinsert bodies that have left their
+    /// fat boxes. rebuilds the tree if bodies have been added or removed.
+    /// sleeping bodies keep their boxes.
+    void update(const std::vector<RigidBody>& bodies);
+
+    /// remove all bodies
+    void clear();
+
+    /// find the pairs of bodies with overlapping (tight) boxes, except pairs
+    /// of sleeping bodies, in lexicographic order (the order of testing all
+    /// pairs i < j)
+    void find_pairs();
+
+    /// pairs found by find_pairs()
+    const std::vector<Pair>& pairs() const { return pairs_; }
+
+    /// collect the bodies whose box contains point `p`
+    void query(const vec2& p, std::vector<int>& bodies) const;
+
+    /// collect the bodies whose box is hit by the segment from `from` to `to`
+    void ray_cast(const vec2& from, const vec2& to,
+                  std::vector<int>& bodies) const;
+
+    /// find the point of `bodies` (as passed to update()) closest to `p`.
+    /// returns false if there are no bodies.
+    bool closest_point(const std::vector<RigidBody>& bodies, const vec2& p,
+                       int& body, int& point) const;
+
+    /// height of the tree (0 for a single leaf, -1 if empty)
+    int height() const { return root_ < 0 ? -1 : nodes_[root_].height; }
+
+private:
+    /// node of the tree. leaves have no children and store a body.
+    struct Node
+    {
+        Box box;      ///< fat box of a leaf, union of the children otherwise
+        int parent;   ///< parent node (next free node if unused)
+        int child[2]; ///< children (-1 for leaves)
+        int body;     ///< body of a leaf
+        int height;   ///< 0 for leaves, -1 for unused nodes
+        bool awake;   ///< is a body in the subtree awake?
+
+        bool is_leaf() const { return child[0] < 0; }
+    };
+
+    /// get an unused node
+    int allocate_node();
+    /// return a node to the free list
+    void free_node(int node);
+
+    /// insert `leaf` next to the sibling of least cost
+    void insert_leaf(int leaf);
+    /// remove `leaf` from the tree (the node stays allocated)
+    void remove_leaf(int leaf);
+
+    /// refit boxes and heights from `node` up to the root, rebalance
+    void refit(int node);
+    /// rotate the subtree of `node` if it is unbalanced, return its new root
+    int balance(int node);
+
+private:
+    float margin_; ///< fat box margin, relative to the body radius
+
+    std::vector<Node> nodes_; ///< all nodes, used and unused
+    int root_;                ///< root node (-1 if empty)
+    int free_list_;           ///< first unused node (-1 if none)
+
+    std::vector<int> leaves_; ///< leaf node of each body
+    std::vector<Box> boxes_;  ///< tight box of each body
+    std::vector<Pair> pairs_; ///< overlapping pairs
+
+    std::vector<Pair> pair_stack_;   ///< traversal stack of find_pairs()
+    mutable std::vector<int> stack_; ///< traversal stack of queries
+};
+
+//=============================================================================
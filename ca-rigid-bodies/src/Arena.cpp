@@ -0,0 +1,173 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+
+#include "Arena.h"
+#include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+//== IMPLEMENTATION ==========================================================
+
+Arena::Arena() : offset_(0), used_(0)
+{
+    main_.data = nullptr;
+    main_.size = 0;
+    main_.mapped = false;
+    huge_pages_ = false;
+}
+
+//-----------------------------------------------------------------------------
+
+Arena::~Arena()
+{
+    reset();
+    free_block(main_);
+}
+
+//-----------------------------------------------------------------------------
+
+void Arena::reserve(size_t bytes, bool huge_pages)
+{
+    reset();
+
+    bytes = aligned_size(bytes);
+    if (bytes > main_.size || huge_pages != huge_pages_)
+    {
+        free_block(main_);
+        main_ = allocate_block(bytes, huge_pages);
+        huge_pages_ = huge_pages;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void* Arena::allocate(size_t bytes)
+{
+    bytes = aligned_size(bytes ? bytes : 1);
+    used_ += bytes;
+
+    // bump the pointer in the main block
+    if (offset_ + bytes <= main_.size)
+    {
+        void* ptr = main_.data + offset_;
+        offset_ += bytes;
+        return ptr;
+    }
+
+    // capacity exceeded: allocate a separate block
+    overflow_.push_back(allocate_block(bytes, false));
+    return overflow_.back().data;
+}
+
+//-----------------------------------------------------------------------------
+
+void Arena::reset()
+{
+    // if the capacity was too small, enlarge the main block such that the
+    // next scene of the same size fits into it
+    if (!overflow_.empty())
+    {
+        for (Block& block : overflow_)
+            free_block(block);
+        overflow_.clear();
+
+        free_block(main_);
+        main_ = allocate_block(aligned_size(used_), huge_pages_);
+    }
+
+    offset_ = 0;
+    used_ = 0;
+}
+
+//-----------------------------------------------------------------------------
+
+Arena::Block Arena::allocate_block(size_t bytes, bool huge_pages)
+{
+    Block block;
+    block.size = bytes;
+    block.mapped = false;
+    block.data = nullptr;
+    if (!bytes)
+        return block;
+
+#if defined(__linux__)
+    // transparent huge pages for large blocks (2MB pages)
+    const size_t huge_page_size = size_t(2) << 20;
+    if (huge_pages && bytes >= huge_page_size)
+    {
+        block.size = (bytes + huge_page_size - 1) & ~(huge_page_size - 1);
+        void* ptr = mmap(nullptr, block.size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr != MAP_FAILED)
+        {
+            madvise(ptr, block.size, MADV_HUGEPAGE);
+            block.data = static_cast<char*>(ptr);
+            block.mapped = true;
+            return block;
+        }
+        block.size = bytes;
+    }
+#else
+    (void)huge_pages;
+#endif
+
+    block.data = static_cast<char*>(aligned_malloc(bytes));
+    return block;
+}
+
+//-----------------------------------------------------------------------------
+
+void Arena::free_block(Block& block)
+{
+#if defined(__linux__)
+    if (block.mapped)
+        munmap(block.data, block.size);
+    else
+#endif
+        aligned_free(block.data);
+
+    block.data = nullptr;
+    block.size = 0;
+    block.mapped = false;
+}
+
+//-----------------------------------------------------------------------------
+
+void* Arena::aligned_malloc(size_t bytes)
+{
+    void* ptr = nullptr;
+#if defined(_WIN32)
+    ptr = _aligned_malloc(bytes, alignment);
+#else
+    if (posix_memalign(&ptr, alignment, bytes))
+        ptr = nullptr;
+#endif
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+//-----------------------------------------------------------------------------
+
+void Arena::aligned_free(void* ptr)
+{
+#if defined(_WIN32)
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+//=============================================================================
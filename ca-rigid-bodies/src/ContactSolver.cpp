@@ -0,0 +1,341 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+
+#include "ContactSolver.h"
+
+#include <algorithm>
+#include <cstdint>
+
+//== IMPLEMENTATION ==========================================================
+
+// fraction of the penetration removed per time step
+static const float baumgarte = 0.2;
+// penetration that is tolerated, avoids jitter of resting contacts
+static const float slop = 0.001;
+// slower impacts do not bounce, avoids jitter of resting contacts
+static const float restitution_threshold = 0.1;
+
+// z-component of the cross product of two 2D vectors
+static inline float cross(const vec2& a, const vec2& b)
+{
+    return a[0] * b[1] - a[1] * b[0];
+}
+
+// velocity of the point at offset `r` of body `b`
+static inline vec2 velocity(const RigidBody& b, const vec2& r)
+{
+    return b.linear_velocity + b.angular_velocity * perp(r);
+}
+
+//-----------------------------------------------------------------------------
+
+size_t ContactSolver::KeyHash::operator()(const Key& k) const
+{
+    // mix bodies and feature id by multiplication with large odd constants
+    uint64_t h = (uint64_t)(uint32_t)k.a * 0x9E3779B97F4A7C15ull;
+    h ^= (uint64_t)(uint32_t)k.b * 0xC2B2AE3D27D4EB4Full;
+    h ^= (uint64_t)k.id * 0x165667B19E3779F9ull;
+    return (size_t)(h ^ (h >> 32));
+}
+
+//-----------------------------------------------------------------------------
+
+ContactSolver::ContactSolver()
+    : iterations(10),
+      friction(0.5),
+      restitution(0.0),
+      warm_starting(true),
+      linear(true),
+      angular(true),
+      step_(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+void ContactSolver::begin_step()
+{
+    ++step_;
+    contacts_.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+void ContactSolver::clear()
+{
+    contacts_.clear();
+    cache_.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+void ContactSolver::add_contact(int a, int b, unsigned int id,
+                                const vec2& point, const vec2& normal,
+                                float depth)
+{
+    Contact c;
+    c.a = a;
+    c.b = b;
+    c.id = id;
+    c.point = point;
+    c.normal = normal;
+    c.depth = depth;
+    c.normal_impulse = c.tangent_impulse = 0.0;
+    contacts_.push_back(c);
+}
+
+//-----------------------------------------------------------------------------
+
+void ContactSolver::find_islands(int n_bodies)
+{
+    // union-find over the bodies in contact, walls do not connect
+    parent_.resize(n_bodies);
+    for (int i = 0; i < n_bodies; ++i)
+        parent_[i] = i;
+    for (const Contact& c : contacts_)
+    {
+        if (c.b < 0)
+            continue;
+        const int ra = find_root(c.a), rb = find_root(c.b);
+        // the smaller body becomes the root
+        if (ra < rb)
+            parent_[rb] = ra;
+        else
+            parent_[ra] = rb;
+    }
+
+    // number the islands, bodies without contacts are islands of their own.
+    // a root is the smallest body of its island, it is numbered first.
+    island_.resize(n_bodies);
+    int n = 0;
+    for (int i = 0; i < n_bodies; ++i)
+    {
+        const int root = find_root(i);
+        island_[i] = root == i ? n++ : island_[root];
+    }
+
+    // count the contacts of each island
+    island_offsets_.assign(n + 1, 0);
+    for (const Contact& c : contacts_)
+        ++island_offsets_[island_[c.a] + 1];
+    for (int i = 1; i <= n; ++i)
+        island_offsets_[i] += island_offsets_[i - 1];
+
+    // group the contacts by island, keeping their order within islands
+    island_contacts_.resize(contacts_.size());
+    for (int k = 0; k < (int)contacts_.size(); ++k)
+        island_contacts_[island_offsets_[island_[contacts_[k].a]]++] = k;
+    for (int i = island_offsets_.size() - 1; i > 0; --i)
+        island_offsets_[i] = island_offsets_[i - 1];
+    island_offsets_[0] = 0;
+}
+
+//-----------------------------------------------------------------------------
+
+int ContactSolver::find_root(int body)
+{
+    // path halving keeps the trees flat
+    while (parent_[body] != body)
+    {
+        parent_[body] = parent_[parent_[body]];
+        body = parent_[body];
+    }
+    return body;
+}
+
+//-----------------------------------------------------------------------------
+
+void ContactSolver::prepare(const int* contacts, int n_contacts,
+                            std::vector<RigidBody>& bodies, float dt)
+{
+    for (int k = 0; k < n_contacts; ++k)
+    {
+        Contact& c = contacts_[contacts[k]];
+        const RigidBody& A = bodies[c.a];
+        c.ima = linear ? 1.0 / A.mass : 0.0;
+        c.iia = angular ? 1.0 / A.inertia : 0.0;
+        c.ra = c.point - A.position;
+
+        // walls do not move
+        c.imb = c.iib = 0.0;
+        c.rb = vec2(0, 0);
+        if (c.b >= 0)
+        {
+            const RigidBody& B = bodies[c.b];
+            c.imb = linear ? 1.0 / B.mass : 0.0;
+            c.iib = angular ? 1.0 / B.inertia : 0.0;
+            c.rb = c.point - B.position;
+        }
+
+        const vec2 n = c.normal, t = perp(n);
+        const float rna = cross(c.ra, n), rnb = cross(c.rb, n);
+        const float rta = cross(c.ra, t), rtb = cross(c.rb, t);
+        const float kn =
+            c.ima + c.imb + c.iia * rna * rna + c.iib * rnb * rnb;
+        const float kt =
+            c.ima + c.imb + c.iia * rta * rta + c.iib * rtb * rtb;
+        c.normal_mass = kn > 0.0 ? 1.0 / kn : 0.0;
+        c.tangent_mass = kt > 0.0 ? 1.0 / kt : 0.0;
+
+        // bounce off fast impacts, push out penetrations
+        const float vn = dot(n, relative_velocity(c, bodies));
+        c.bias = vn < -restitution_threshold ? -restitution * vn : 0.0;
+        c.bias =
+            std::max(c.bias, baumgarte / dt * std::max(c.depth - slop, 0.0f));
+    }
+
+    // start from the impulses of the same contacts in the previous step.
+    // only now, the velocities above must not contain these impulses.
+    for (int k = 0; k < n_contacts; ++k)
+    {
+        Contact& c = contacts_[contacts[k]];
+        auto cached = warm_starting ? cache_.find(Key{c.a, c.b, c.id})
+                                    : cache_.end();
+        if (cached != cache_.end() && cached->second.step + 1 == step_)
+        {
+            c.normal_impulse = cached->second.normal_impulse;
+            c.tangent_impulse = cached->second.tangent_impulse;
+            apply(c,
+                  c.normal_impulse * c.normal +
+                      c.tangent_impulse * perp(c.normal),
+                  bodies);
+        }
+        else
+        {
+            c.normal_impulse = c.tangent_impulse = 0.0;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void ContactSolver::solve(std::vector<RigidBody>& bodies, float dt,
+                          ThreadPool* pool)
+{
+    find_islands(bodies.size());
+    const int n = n_islands();
+
+    if (!pool || pool->size() < 2)
+    {
+        for (int i = 0; i < n; ++i)
+            solve_island(i, bodies, dt);
+    }
+    else
+    {
+        // tasks of consecutive islands with enough contacts to outweigh the
+        // cost of a task, the pool balances large and small tasks
+        const int min_contacts = 64;
+        for (int first = 0, last; first < n; first = last)
+        {
+            for (last = first + 1;
+                 last < n && island_offsets_[last] - island_offsets_[first] <
+                                 min_contacts;
+                 ++last)
+                ;
+            pool->submit([this, first, last, &bodies, dt]() {
+                for (int i = first; i < last; ++i)
+                    solve_island(i, bodies, dt);
+            });
+        }
+        pool->wait();
+    }
+
+    refresh_cache();
+}
+
+//-----------------------------------------------------------------------------
+
+void ContactSolver::solve_island(int i, std::vector<RigidBody>& bodies,
+                                 float dt)
+{
+    const int* contacts = island_contacts_.data() + island_offsets_[i];
+    const int n_contacts = island_offsets_[i + 1] - island_offsets_[i];
+
+    prepare(contacts, n_contacts, bodies, dt);
+
+    for (int iteration = 0; iteration < iterations; ++iteration)
+    {
+        for (int k = 0; k < n_contacts; ++k)
+        {
+            Contact& c = contacts_[contacts[k]];
+            const vec2 n = c.normal, t = perp(n);
+
+            // friction, bounded by the current normal impulse
+            float lambda =
+                -c.tangent_mass * dot(relative_velocity(c, bodies), t);
+            const float max_friction = friction * c.normal_impulse;
+            float accumulated =
+                std::min(std::max(c.tangent_impulse + lambda, -max_friction),
+                         max_friction);
+            apply(c, (accumulated - c.tangent_impulse) * t, bodies);
+            c.tangent_impulse = accumulated;
+
+            // normal impulse, must not pull the bodies together
+            lambda = -c.normal_mass *
+                     (dot(relative_velocity(c, bodies), n) - c.bias);
+            accumulated = std::max(c.normal_impulse + lambda, 0.0f);
+            apply(c, (accumulated - c.normal_impulse) * n, bodies);
+            c.normal_impulse = accumulated;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void ContactSolver::refresh_cache()
+{
+    // insert new contacts, overwrite the impulses of persisting ones
+    for (const Contact& c : contacts_)
+        cache_[Key{c.a, c.b, c.id}] =
+            CachedImpulse{c.normal_impulse, c.tangent_impulse, step_};
+
+    // contacts that have not been found again are gone. the map has about
+    // as many entries as there are contacts, sweeping it is cheap.
+    if (cache_.size() > contacts_.size())
+    {
+        for (auto it = cache_.begin(); it != cache_.end();)
+        {
+            if (it->second.step != step_)
+                it = cache_.erase(it);
+            else
+                ++it;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void ContactSolver::apply(const Contact& c, const vec2& P,
+                          std::vector<RigidBody>& bodies)
+{
+    RigidBody& A = bodies[c.a];
+    A.linear_velocity += c.ima * P;
+    A.angular_velocity += c.iia * cross(c.ra, P);
+
+    if (c.b >= 0)
+    {
+        RigidBody& B = bodies[c.b];
+        B.linear_velocity -= c.imb * P;
+        B.angular_velocity -= c.iib * cross(c.rb, P);
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+vec2 ContactSolver::relative_velocity(const Contact& c,
+                                      const std::vector<RigidBody>& bodies)
+{
+    vec2 v = velocity(bodies[c.a], c.ra);
+    if (c.b >= 0)
+        v -= velocity(bodies[c.b], c.rb);
+    return v;
+}
+
+//=============================================================================
@@ -0,0 +1,169 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+#pragma once
+//=============================================================================
+
+#include "RigidBody.h"
+#include "ThreadPool.h"
+
+#include <unordered_map>
+#include <vector>
+
+//== CLASS DEFINITION =========================================================
+
+/** \class ContactSolver ContactSolver.h
+ Sequential impulse solver (projected Gauss-Seidel) for the contacts of one
+ time step. The velocities of the bodies are corrected iteratively, contact
+ by contact, such that no contact point approaches. The impulses of each
+ contact are accumulated over the iterations and clamped as a whole: the
+ normal impulse must not pull, the friction impulse is bounded by the
+ Coulomb cone. Penetrations are removed by a velocity bias (Baumgarte).
+
+ Contacts are identified by their bodies and feature ids. Their accumulated
+ impulses are kept in a hash map across time steps and applied at the start
+ of the next step (warm starting), so resting contacts start close to their
+ solution and stacks settle in a few iterations. Entries of contacts that
+ have not been found again in a step expire.
+
+ Bodies connected by contacts form islands (walls do not connect). Islands
+ do not share bodies, so they are solved independently, optionally
+ concurrently on a thread pool, with the same result as solving them one
+ after the other.
+ */
+class ContactSolver
+{
+public:
+    /// a contact point between body `a` and body `b` (or a wall, b < 0)
+    struct Contact
+    {
+        int a;           ///< first body
+        int b;           ///< second body, -1 for walls
+        unsigned int id; ///< feature id, identifies the contact over steps
+        vec2 point;      ///< contact point
+        vec2 normal;     ///< contact normal (pointing from b towards a)
+        float depth;     ///< penetration depth
+
+        vec2 ra, rb;           ///< contact point relative to the bodies
+        float ima, imb;        ///< inverse masses (0 for walls)
+        float iia, iib;        ///< inverse moments of inertia (0 for walls)
+        float normal_mass;     ///< effective mass along the normal
+        float tangent_mass;    ///< effective mass along the tangent
+        float bias;            ///< target normal velocity
+        float normal_impulse;  ///< accumulated normal impulse
+        float tangent_impulse; ///< accumulated friction impulse
+    };
+
+    /// constructor with default parameters
+    ContactSolver();
+
+    /// start a new time step: the contacts of the previous step are
+    /// forgotten, their impulses stay cached for warm starting
+    void begin_step();
+
+    /// forget all contacts (e.g. when bodies have been added or removed)
+    void clear();
+
+    /// add a contact of the current step
+    void add_contact(int a, int b, unsigned int id, const vec2& point,
+                     const vec2& normal, float depth);
+
+    /// contacts of the current step
+    const std::vector<Contact>& contacts() const { return contacts_; }
+
+    /// correct the velocities of `bodies` for the contacts of the current
+    /// step, with time step `dt`. refreshes the cached impulses. islands are
+    /// solved on `pool` if given.
+    void solve(std::vector<RigidBody>& bodies, float dt,
+               ThreadPool* pool = nullptr);
+
+    /// number of islands of the current step (after solve()). bodies
+    /// without contacts are islands of their own.
+    int n_islands() const
+    {
+        return island_offsets_.empty() ? 0 : island_offsets_.size() - 1;
+    }
+
+    /// island of `body` in the current step (after solve())
+    int island(int body) const { return island_[body]; }
+
+    /// number of cached contact impulses
+    size_t n_cached() const { return cache_.size(); }
+
+public:
+    int iterations;     ///< number of velocity iterations
+    float friction;     ///< Coulomb friction coefficient
+    float restitution;  ///< coefficient of restitution
+    bool warm_starting; ///< start from the impulses of the previous step
+    bool linear;        ///< apply impulses to linear velocities
+    bool angular;       ///< apply impulses to angular velocities
+
+private:
+    /// identifies a contact over time steps
+    struct Key
+    {
+        int a, b;
+        unsigned int id;
+
+        bool operator==(const Key& k) const
+        {
+            return a == k.a && b == k.b && id == k.id;
+        }
+    };
+
+    /// hash of bodies and feature id
+    struct KeyHash
+    {
+        size_t operator()(const Key& k) const;
+    };
+
+    /// accumulated impulses of a contact
+    struct CachedImpulse
+    {
+        float normal_impulse;
+        float tangent_impulse;
+        unsigned int step; ///< last step the contact has been found in
+    };
+
+    /// group the contacts by islands of connected bodies
+    void find_islands(int n_bodies);
+
+    /// root of the union-find tree of `body`
+    int find_root(int body);
+
+    /// solve the contacts of island `i`
+    void solve_island(int i, std::vector<RigidBody>& bodies, float dt);
+
+    /// compute effective masses and bias of the given contacts, apply their
+    /// cached impulses
+    void prepare(const int* contacts, int n_contacts,
+                 std::vector<RigidBody>& bodies, float dt);
+
+    /// store the impulses of the current contacts, expire the others
+    void refresh_cache();
+
+    /// apply impulse `P` at contact `c` to body a, and `-P` to body b
+    static void apply(const Contact& c, const vec2& P,
+                      std::vector<RigidBody>& bodies);
+
+    /// velocity of body a relative to body b at contact `c`
+    static vec2 relative_velocity(const Contact& c,
+                                  const std::vector<RigidBody>& bodies);
+
+    std::vector<Contact> contacts_; ///< contacts of the current step
+    std::unordered_map<Key, CachedImpulse, KeyHash> cache_; ///< impulses
+    unsigned int step_; ///< counts the time steps
+
+    std::vector<int> parent_;          ///< union-find forest of the bodies
+    std::vector<int> island_;          ///< island of each body
+    std::vector<int> island_contacts_; ///< contacts, grouped by island
+    std::vector<int> island_offsets_;  ///< first contact of each island
+};
+
+//=============================================================================
@@ -0,0 +1,65 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+
+#include "FrameWriter.h"
+
+#include <stb_image_write.h>
+
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+//== IMPLEMENTATION ==========================================================
+
+FrameWriter::FrameWriter(const std::string& directory, unsigned int n_threads)
+    : directory_(directory),
+      pool_(n_threads),
+      n_frames_(0),
+      n_pending_(0),
+      failed_(false)
+{
+    // frames are mostly flat colors, strong compression hardly pays off
+    stbi_write_png_compression_level = 1;
+}
+
+//-----------------------------------------------------------------------------
+
+void FrameWriter::write(const Rasterizer& rasterizer)
+{
+    // bound the memory of pending frames
+    if (n_pending_ >= 2 * pool_.size())
+        pool_.wait();
+
+    char name[32];
+    snprintf(name, sizeof(name), "/frame_%05u.png", n_frames_++);
+    const std::string filename = directory_ + name;
+
+    // the task owns a copy of the framebuffer
+    const unsigned int w = rasterizer.width(), h = rasterizer.height();
+    std::shared_ptr<std::vector<unsigned char>> pixels(
+        new std::vector<unsigned char>(rasterizer.pixels()));
+
+    ++n_pending_;
+    pool_.submit([this, filename, w, h, pixels]() {
+        if (!stbi_write_png(filename.c_str(), w, h, 3, pixels->data(), 3 * w))
+            failed_ = true;
+        --n_pending_;
+    });
+}
+
+//-----------------------------------------------------------------------------
+
+bool FrameWriter::finish()
+{
+    pool_.wait();
+    return !failed_;
+}
+
+//=============================================================================
@@ -0,0 +1,81 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+#pragma once
+//=============================================================================
+
+#include <pmp/MatVec.h>
+using namespace pmp;
+
+#include <vector>
+
+//== CLASS DEFINITION =========================================================
+
+/** \class Rasterizer Rasterizer.h
+ Renders 2D primitives into an RGB framebuffer in main memory, which allows
+ to export frames without a window or OpenGL context. Primitives are given
+ in world coordinates, the rectangle [bbmin, bbmax] is fit into the image
+ (preserving its aspect ratio) and later primitives are drawn on top of
+ earlier ones. Pixels are covered if their centers are inside a primitive,
+ there is no anti-aliasing.
+ */
+class Rasterizer
+{
+public:
+    /// constructor, allocates a width x height framebuffer
+    Rasterizer(unsigned int width, unsigned int height,
+               vec2 bbmin = vec2(-1.1, -1.1), vec2 bbmax = vec2(1.1, 1.1));
+
+    /// fill the whole framebuffer with `color`
+    void clear(const vec3& color = vec3(1, 1, 1));
+
+    /// fill triangle (a,b,c), given in either orientation
+    void fill_triangle(const vec2& a, const vec2& b, const vec2& c,
+                       const vec3& color);
+
+    /// draw line segment from a to b that is `width` pixels wide
+    void draw_line(const vec2& a, const vec2& b, float width,
+                   const vec3& color);
+
+    /// fill disc of `radius` (in world units) around `center`
+    void fill_disc(const vec2& center, float radius, const vec3& color);
+
+    /// width of the framebuffer
+    unsigned int width() const { return width_; }
+    /// height of the framebuffer
+    unsigned int height() const { return height_; }
+    /// RGB pixels, row by row from the top
+    const std::vector<unsigned char>& pixels() const { return pixels_; }
+
+private:
+    /// pixel coordinates of world point p
+    vec2 to_pixel(const vec2& p) const
+    {
+        return vec2(offset_[0] + scale_ * p[0], offset_[1] - scale_ * p[1]);
+    }
+
+    /// set pixel (x,y) to `rgb`
+    void set(int x, int y, const unsigned char rgb[3])
+    {
+        unsigned char* pixel = &pixels_[3 * (y * width_ + x)];
+        pixel[0] = rgb[0];
+        pixel[1] = rgb[1];
+        pixel[2] = rgb[2];
+    }
+
+    /// fill triangle given in pixel coordinates
+    void fill_pixel_triangle(vec2 a, vec2 b, vec2 c, const vec3& color);
+
+    unsigned int width_, height_;       ///< size of the framebuffer
+    float scale_;                       ///< pixels per world unit
+    vec2 offset_;                       ///< pixel position of the origin
+    std::vector<unsigned char> pixels_; ///< RGB framebuffer
+};
+
+//=============================================================================
@@ -10,14 +10,122 @@
 
 #include "RigidBody.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
 //== IMPLEMENTATION ==========================================================
 
+void batch_sincos(const float* angles, float* sines, float* cosines, size_t n)
+{
+    // pi/2 split into three parts, such that q * pi/2 is exact
+    const float pio2_1 = 1.5703125f;
+    const float pio2_2 = 4.837512969970703125e-4f;
+    const float pio2_3 = 7.54978995489188216e-8f;
+    const float two_over_pi = 0.636619772367581343f;
+    // adding and subtracting 1.5 * 2^23 rounds to the nearest integer
+    const float round = 12582912.0f;
+    // q * pio2_2 is exact for |q| < 2^13, larger angles are left to the
+    // standard library
+    const float max_angle = 1.0e4f;
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        // reduce to x in [-pi/4, pi/4] and quadrant q. the lowest bits of t
+        // hold q, reading them is defined for any angle, unlike (int)qf.
+        const float t = angles[i] * two_over_pi + round;
+        const float qf = t - round;
+        uint32_t q;
+        std::memcpy(&q, &t, sizeof(q));
+        const float x =
+            ((angles[i] - qf * pio2_1) - qf * pio2_2) - qf * pio2_3;
+
+        // minimax polynomials on [-pi/4, pi/4]
+        const float x2 = x * x;
+        const float s =
+            x + x * x2 *
+                    (-1.6666654611e-1f +
+                     x2 * (8.3321608736e-3f + x2 * -1.9515295891e-4f));
+        const float c =
+            1.0f - 0.5f * x2 +
+            x2 * x2 *
+                (4.166664568298827e-2f +
+                 x2 * (-1.388731625493765e-3f + x2 * 2.443315711809948e-5f));
+
+        // rotate by q quarter turns
+        const bool odd = q & 1;
+        sines[i] = (odd ? c : s) * ((q & 2) ? -1.0f : 1.0f);
+        cosines[i] = (odd ? s : c) * (((q + 1) & 2) ? -1.0f : 1.0f);
+    }
+
+    // bodies spinning for thousands of turns, or NaN
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (!(std::fabs(angles[i]) <= max_angle))
+        {
+            sines[i] = std::sin(angles[i]);
+            cosines[i] = std::cos(angles[i]);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+// transform vertices `begin` to `end`-1 of the interleaved (x,y) arrays.
+// restricted pointers and int indices, such that the compiler vectorizes
+// the loop and turns the lookups of the bodies into gathers.
+static void transform_vertices(int begin, int end,
+                               float* __restrict points,
+                               float* __restrict normals,
+                               const float* __restrict r,
+                               const float* __restrict local_normals,
+                               const int* __restrict body,
+                               const float* __restrict centers,
+                               const float* __restrict cosines,
+                               const float* __restrict sines)
+{
+    for (int i = begin; i < end; ++i)
+    {
+        const int j = body[i];
+        const float c = cosines[j], s = sines[j];
+        const float rx = r[2 * i], ry = r[2 * i + 1];
+        const float nx = local_normals[2 * i], ny = local_normals[2 * i + 1];
+        points[2 * i] = centers[2 * j] + c * rx - s * ry;
+        points[2 * i + 1] = centers[2 * j + 1] + s * rx + c * ry;
+        normals[2 * i] = c * nx - s * ny;
+        normals[2 * i + 1] = s * nx + c * ny;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void VertexPool::transform(int begin, int end, const vec2* centers,
+                           const float* cosines, const float* sines)
+{
+    if (begin < end)
+        transform_vertices(begin, end, points[0].data(), normals[0].data(),
+                           r[0].data(), local_normals[0].data(), body.data(),
+                           centers[0].data(), cosines, sines);
+}
+
+//=============================================================================
+
 RigidBody::RigidBody(const std::vector<vec2>& _points, float _mass,
-                     const vec2 linVelocity)
-    : color(0, 0, 1)
+                     const vec2 linVelocity, VertexPool& pool)
+    : color(0, 0, 1),
+      sleeping(false),
+      rest_time(0.0),
+      sleep_island(-1),
+      offset(pool.size())
 {
-    // copy points and mass
-    points = _points;
+    // append the vertices to the pool
+    pool.resize(offset + _points.size());
+    points = VertexRange<vec2>(nullptr, _points.size());
+    bind(pool);
+    std::copy(_points.begin(), _points.end(), points.begin());
+
+    // copy mass
     mass = _mass;
 
     // compute center of mass
@@ -40,12 +148,35 @@ RigidBody::RigidBody(const std::vector<vec2>& _points, float _mass,
     }
 
     // compute points in local coordinate system
-    r.resize(points.size());
     for (unsigned int i = 0; i < points.size(); ++i)
     {
         r[i] = points[i] - position;
     }
 
+    // compute outward edge normals, for either orientation of the polygon
+    const int n = points.size();
+    float area = 0.0;
+    for (int i = 0; i < n; ++i)
+    {
+        const vec2 &a = points[i], &b = points[(i + 1) % n];
+        area += a[0] * b[1] - a[1] * b[0];
+    }
+    for (int i = 0; i < n; ++i)
+    {
+        const vec2 e = points[(i + 1) % n] - points[i];
+        local_normals[i] =
+            normalize(area >= 0.0 ? vec2(e[1], -e[0]) : vec2(-e[1], e[0]));
+    }
+    std::copy(local_normals.begin(), local_normals.end(), normals.begin());
+
+    // compute bounding box
+    box_min = box_max = position;
+    for (auto p : points)
+    {
+        box_min = min(box_min, p);
+        box_max = max(box_max, p);
+    }
+
     // compute moment of inertia
     inertia = 0.0;
     float mi = mass / (float)points.size();
@@ -65,15 +196,48 @@ RigidBody::RigidBody(const std::vector<vec2>& _points, float _mass,
 
 //-----------------------------------------------------------------------------
 
+void RigidBody::bind(VertexPool& pool)
+{
+    const unsigned int n = points.size();
+    points = VertexRange<vec2>(pool.points.data() + offset, n);
+    r = VertexRange<vec2>(pool.r.data() + offset, n);
+    normals = VertexRange<vec2>(pool.normals.data() + offset, n);
+    local_normals = VertexRange<vec2>(pool.local_normals.data() + offset, n);
+}
+
+//-----------------------------------------------------------------------------
+
 void RigidBody::update_points()
 {
-    const float s = sin(orientation), c = cos(orientation);
+    float s, c;
+    batch_sincos(&orientation, &s, &c, 1);
 
     for (unsigned int i = 0; i < points.size(); ++i)
     {
         points[i] = position +
                     vec2(c * r[i][0] - s * r[i][1], s * r[i][0] + c * r[i][1]);
+
+        // rotate the cached normals instead of recomputing them
+        const vec2 &n = local_normals[i];
+        normals[i] = vec2(c * n[0] - s * n[1], s * n[0] + c * n[1]);
+    }
+
+    update_box();
+}
+
+//-----------------------------------------------------------------------------
+
+void RigidBody::update_box()
+{
+    // local bounds, the members might alias the points for the compiler
+    vec2 lower = position, upper = position;
+    for (const vec2& p : points)
+    {
+        lower = min(lower, p);
+        upper = max(upper, p);
     }
+    box_min = lower;
+    box_max = upper;
 }
 
 //=============================================================================
@@ -10,12 +10,132 @@
 #pragma once
 //=============================================================================
 
+#include <algorithm>
 #include <vector>
 #include <pmp/MatVec.h>
+#include "Arena.h"
 using namespace pmp;
 
 //== CLASS DEFINITION =========================================================
 
+/** \class VertexRange RigidBody.h
+ The contiguous range of the vertices of one rigid body in a VertexPool.
+ */
+template <class T>
+class VertexRange
+{
+public:
+    /// empty range
+    VertexRange() : data_(nullptr), size_(0) {}
+    /// the `size` elements starting at `data`
+    VertexRange(T* data, unsigned int size) : data_(data), size_(size) {}
+
+    /// number of vertices
+    unsigned int size() const { return size_; }
+    /// is the range empty?
+    bool empty() const { return size_ == 0; }
+
+    /// access vertex `i`
+    T& operator[](unsigned int i) const { return data_[i]; }
+
+    /// iterators for range-based for loops
+    T* begin() const { return data_; }
+    T* end() const { return data_ + size_; }
+
+private:
+    T* data_;
+    unsigned int size_;
+};
+
+//=============================================================================
+
+/** \class VertexPool RigidBody.h
+ The vertex arrays of all rigid bodies of a scene, one contiguous array per
+ attribute. Each body refers to a range of vertices, such that transforming
+ all bodies streams linearly through memory and adding a body does not
+ allocate per body. The arrays are taken from an Arena.
+ */
+class VertexPool
+{
+public:
+    /// construct with memory from `arena` (or the heap if nullptr)
+    explicit VertexPool(Arena* arena = nullptr)
+        : points(ArenaAllocator<vec2>(arena)),
+          r(ArenaAllocator<vec2>(arena)),
+          normals(ArenaAllocator<vec2>(arena)),
+          local_normals(ArenaAllocator<vec2>(arena)),
+          body(ArenaAllocator<int>(arena))
+    {
+    }
+
+    /// number of vertices
+    size_t size() const { return points.size(); }
+
+    /// number of vertices all arrays can hold without moving
+    size_t capacity() const
+    {
+        return std::min({points.capacity(), r.capacity(), normals.capacity(),
+                         local_normals.capacity(), body.capacity()});
+    }
+
+    /// resize all arrays to `n` vertices. growing may move the arrays, the
+    /// ranges of the bodies have to be bound again.
+    void resize(size_t n)
+    {
+        points.resize(n);
+        r.resize(n);
+        normals.resize(n);
+        local_normals.resize(n);
+        body.resize(n);
+    }
+
+    /// plan the memory for `n` vertices
+    void reserve(size_t n)
+    {
+        points.reserve(n);
+        r.reserve(n);
+        normals.reserve(n);
+        local_normals.reserve(n);
+        body.reserve(n);
+    }
+
+    /// remove all vertices and drop their memory (e.g. before the arena
+    /// is reset)
+    void release()
+    {
+        ArenaVector<vec2>(points.get_allocator()).swap(points);
+        ArenaVector<vec2>(r.get_allocator()).swap(r);
+        ArenaVector<vec2>(normals.get_allocator()).swap(normals);
+        ArenaVector<vec2>(local_normals.get_allocator()).swap(local_normals);
+        ArenaVector<int>(body.get_allocator()).swap(body);
+    }
+
+    /// transform the vertices `begin` to `end`-1 to world coordinates:
+    /// rotate by the angle of their body (given by `cosines` and `sines`)
+    /// and translate by `centers`, all indexed by body. one flat loop over
+    /// the vertices, which the compiler vectorizes.
+    void transform(int begin, int end, const vec2* centers,
+                   const float* cosines, const float* sines);
+
+public:
+    ArenaVector<vec2> points;        ///< point positions
+    ArenaVector<vec2> r;             ///< points relative to the CoG
+    ArenaVector<vec2> normals;       ///< outward normal of edge (i,i+1)
+    ArenaVector<vec2> local_normals; ///< edge normals in local coordinates
+    ArenaVector<int> body;           ///< body of each vertex
+};
+
+//=============================================================================
+
+/// sines and cosines of `n` angles at once. a polynomial approximation
+/// (error about 1e-7) without branches or calls, such that the compiler
+/// vectorizes the loop. angles beyond +-1e4 and NaN are passed to
+/// std::sin/std::cos instead.
+void batch_sincos(const float* angles, float* sines, float* cosines,
+                  size_t n);
+
+//=============================================================================
+
 /** \class Rigid_body Rigid_body.h
  Class for representing a rigid body.
  It represents the rigid body by the position of its center of gravity
@@ -26,16 +146,31 @@ class RigidBody
 {
 public:
     /// default constructur
-    RigidBody() : color(0, 1, 0) {}
+    RigidBody()
+        : color(0, 1, 0),
+          sleeping(false),
+          rest_time(0.0),
+          sleep_island(-1),
+          offset(0)
+    {
+    }
 
-    /// construct with a set of points and a total mass
+    /// construct with a set of points and a total mass. the vertices are
+    /// appended to `pool`, which may move the vertices of other bodies.
     RigidBody(const std::vector<vec2>& _points, float _mass,
-              const vec2 linVelocity = vec2(0, 0));
+              const vec2 linVelocity, VertexPool& pool);
 
-    /// after changing position and orientation,
-    /// call this function to update particle positions
+    /// point the vertex ranges to the arrays of `pool`, e.g. after the pool
+    /// has grown
+    void bind(VertexPool& pool);
+
+    /// after changing position and orientation, call this function to
+    /// update particle positions, edge normals and the bounding box
     void update_points();
 
+    /// update the bounding box from the points
+    void update_box();
+
 public:
     vec2 position;          ///< position of the center of gravity (CoG)
     vec2 linear_velocity;   ///< linear velocity of CoG
@@ -48,8 +183,18 @@ public:
     float radius;           ///< bounding sphere radius
     vec3 color;             ///< use to visualize body-body collisions
 
-    std::vector<vec2> points; ///< vector of particles/points
-    std::vector<vec2> r;      ///< vector of relative point positions
+    bool sleeping;    ///< is the body deactivated while resting?
+    float rest_time;  ///< time the body has been resting
+    int sleep_island; ///< first body of the island it fell asleep with
+
+    unsigned int offset;     ///< first vertex in the pool
+    VertexRange<vec2> points; ///< particles/points
+    VertexRange<vec2> r;      ///< relative point positions
+
+    VertexRange<vec2> normals;       ///< outward normal of edge (i,i+1)
+    VertexRange<vec2> local_normals; ///< edge normals in local coordinates
+    vec2 box_min;                    ///< lower bounds of the points
+    vec2 box_max;                    ///< upper bounds of the points
 };
 
 //=============================================================================
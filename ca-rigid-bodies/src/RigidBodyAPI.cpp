@@ -0,0 +1,262 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+
+#include "RigidBodyAPI.h"
+#include "RigidBodySystem.h"
+
+#include <cmath>
+#include <cstring>
+
+//== IMPLEMENTATION ==========================================================
+
+/// the opaque handle wraps a headless system
+struct rb_system
+{
+    rb_system() : system(false) {}
+    RigidBodySystem system;
+};
+
+//-----------------------------------------------------------------------------
+
+// pointer to parameter `name` of `s`, or nullptr. `type` is set to 'f'
+// (float), 'b' (bool), or 'i' (int), integers must be in [min, max].
+static void* parameter(RigidBodySystem& s, const char* name, char& type,
+                       float& min, float& max)
+{
+    struct Entry
+    {
+        const char* name;
+        void* value;
+        char type;
+        float min, max; ///< range of valid values of integers
+    };
+    const Entry entries[] = {
+        {"gravity", &s.use_gravity_, 'b', 0, 1},
+        {"linear_dynamics", &s.use_linear_dynamics_, 'b', 0, 1},
+        {"angular_dynamics", &s.use_angular_dynamics_, 'b', 0, 1},
+        {"body_collisions", &s.multiple_bodies_mode_, 'b', 0, 1},
+        {"aabb_tree", &s.use_aabb_tree_, 'b', 0, 1},
+        {"time_step", &s.time_step_, 'f', 0, 0},
+        {"mass", &s.mass_, 'f', 0, 0},
+        {"damping", &s.damping_, 'f', 0, 0},
+        {"collision_damping", &s.collision_damping_, 'f', 0, 0},
+        {"collision_elasticity", &s.collision_elasticity_, 'f', 0, 0},
+        {"friction", &s.friction_, 'f', 0, 0},
+        {"solver_iterations", &s.solver_iterations_, 'i', 1, 1e6},
+        {"warm_starting", &s.use_warm_starting_, 'b', 0, 1},
+        {"contact_cache", &s.use_contact_cache_, 'b', 0, 1},
+        {"threads", &s.n_threads_, 'i', 1, 256},
+        {"sleeping", &s.use_sleeping_, 'b', 0, 1},
+        {"sleep_velocity", &s.sleep_velocity_, 'f', 0, 0},
+        {"sleep_time", &s.sleep_time_, 'f', 0, 0},
+    };
+    for (const Entry& e : entries)
+    {
+        if (!strcmp(e.name, name))
+        {
+            type = e.type;
+            min = e.min;
+            max = e.max;
+            return e.value;
+        }
+    }
+    return nullptr;
+}
+
+//-----------------------------------------------------------------------------
+
+// view of `member` (vec2 or float) of all bodies
+template <class T>
+static rb_view body_view(const RigidBodySystem& s, T RigidBody::*member)
+{
+    rb_view view;
+    view.data = s.bodies_.empty()
+                    ? nullptr
+                    : reinterpret_cast<const float*>(&(s.bodies_[0].*member));
+    view.count = s.bodies_.size();
+    view.stride = sizeof(RigidBody);
+    view.components = sizeof(T) / sizeof(float);
+    return view;
+}
+
+//-----------------------------------------------------------------------------
+
+int rb_api_version(void)
+{
+    return RB_API_VERSION;
+}
+
+//-----------------------------------------------------------------------------
+
+rb_system* rb_create(void)
+{
+    return new rb_system;
+}
+
+//-----------------------------------------------------------------------------
+
+void rb_destroy(rb_system* system)
+{
+    delete system;
+}
+
+//-----------------------------------------------------------------------------
+
+int rb_clear(rb_system* system, size_t n_bodies, size_t n_points)
+{
+    system->system.clear_mouse_spring();
+    system->system.clear_bodies(n_bodies, n_points);
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+
+int rb_add_body(rb_system* system, const float* points, size_t n, float vx,
+                float vy)
+{
+    if (n == 0)
+        return -1;
+
+    std::vector<vec2> p(n);
+    for (size_t i = 0; i < n; ++i)
+        p[i] = vec2(points[2 * i], points[2 * i + 1]);
+    system->system.add_body(p, vec2(vx, vy));
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+
+int rb_add_bodies(rb_system* system, const float* points,
+                  const size_t* counts, size_t n_bodies,
+                  const float* velocities)
+{
+    size_t n_points = 0;
+    for (size_t i = 0; i < n_bodies; ++i)
+    {
+        if (counts[i] == 0)
+            return -1;
+        n_points += counts[i];
+    }
+    system->system.reserve_bodies(n_bodies, n_points);
+
+    std::vector<vec2> p;
+    for (size_t i = 0; i < n_bodies; ++i)
+    {
+        p.resize(counts[i]);
+        for (size_t j = 0; j < counts[i]; ++j, points += 2)
+            p[j] = vec2(points[0], points[1]);
+        const vec2 v = velocities ? vec2(velocities[2 * i],
+                                         velocities[2 * i + 1])
+                                  : vec2(0, 0);
+        system->system.add_body(p, v);
+    }
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+
+int rb_set_parameter(rb_system* system, const char* name, float value)
+{
+    char type;
+    float min, max;
+    void* p = parameter(system->system, name, type, min, max);
+    if (!std::isfinite(value) || !p ||
+        (type == 'i' && (value < min || value > max)))
+        return -1;
+
+    if (type == 'f')
+        *static_cast<float*>(p) = value;
+    else if (type == 'b')
+        *static_cast<bool*>(p) = value != 0.0f;
+    else
+        *static_cast<int*>(p) = int(value);
+
+    // changed parameters may disturb resting bodies
+    system->system.wake_up();
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+
+float rb_get_parameter(const rb_system* system, const char* name)
+{
+    char type;
+    float min, max;
+    void* p = parameter(const_cast<RigidBodySystem&>(system->system), name,
+                        type, min, max);
+    if (!p)
+        return NAN;
+
+    if (type == 'f')
+        return *static_cast<float*>(p);
+    else if (type == 'b')
+        return *static_cast<bool*>(p);
+    else
+        return *static_cast<int*>(p);
+}
+
+//-----------------------------------------------------------------------------
+
+void rb_step(rb_system* system, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        system->system.time_integration();
+}
+
+//-----------------------------------------------------------------------------
+
+size_t rb_n_bodies(const rb_system* system)
+{
+    return system->system.bodies_.size();
+}
+
+//-----------------------------------------------------------------------------
+
+rb_view rb_positions(const rb_system* system)
+{
+    return body_view(system->system, &RigidBody::position);
+}
+
+//-----------------------------------------------------------------------------
+
+rb_view rb_linear_velocities(const rb_system* system)
+{
+    return body_view(system->system, &RigidBody::linear_velocity);
+}
+
+//-----------------------------------------------------------------------------
+
+rb_view rb_orientations(const rb_system* system)
+{
+    return body_view(system->system, &RigidBody::orientation);
+}
+
+//-----------------------------------------------------------------------------
+
+rb_view rb_angular_velocities(const rb_system* system)
+{
+    return body_view(system->system, &RigidBody::angular_velocity);
+}
+
+//-----------------------------------------------------------------------------
+
+rb_view rb_body_points(const rb_system* system, size_t i)
+{
+    rb_view view = {nullptr, 0, sizeof(vec2), 2};
+    if (i < system->system.bodies_.size())
+    {
+        const VertexRange<vec2>& points = system->system.bodies_[i].points;
+        view.data = points.empty() ? nullptr : points[0].data();
+        view.count = points.size();
+    }
+    return view;
+}
+
+//=============================================================================
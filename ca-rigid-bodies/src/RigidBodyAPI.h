@@ -0,0 +1,107 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+#pragma once
+//=============================================================================
+
+/// C interface for driving headless rigid-body simulations from external
+/// tools. A system is created, filled with bodies given by their points,
+/// configured by named parameters, and stepped. Its state is exposed without
+/// copying as strided views into the simulation's own arrays.
+///
+/// Views of rb_positions() and the other per-body arrays stay valid until
+/// more bodies are added than planned by rb_clear. Views of rb_body_points()
+/// stay valid until more points are added than planned by rb_clear, since
+/// the points of all bodies share one pool that moves as a whole when it
+/// grows. Clearing the system invalidates all views. All functions
+/// returning int return 0 on success and -1 on error.
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_WIN32) && defined(RB_API_EXPORTS)
+#define RB_API __declspec(dllexport)
+#elif defined(_WIN32)
+#define RB_API __declspec(dllimport)
+#else
+#define RB_API __attribute__((visibility("default")))
+#endif
+
+/// version of this interface, incremented on incompatible changes
+#define RB_API_VERSION 1
+
+/// opaque handle of a rigid-body system
+typedef struct rb_system rb_system;
+
+/// read-only view of `count` elements of `components` floats each. element
+/// i starts at (const char*)data + i * stride, stride is given in bytes.
+typedef struct
+{
+    const float* data;
+    size_t count;
+    size_t stride;
+    size_t components;
+} rb_view;
+
+/// version of the linked library (RB_API_VERSION it was built with)
+RB_API int rb_api_version(void);
+
+/// create an empty headless system with default parameters and four walls
+RB_API rb_system* rb_create(void);
+/// destroy a system, invalidates all its views
+RB_API void rb_destroy(rb_system* system);
+
+/// remove all bodies and plan the memory for the given numbers of bodies
+/// and points (summed over all bodies)
+RB_API int rb_clear(rb_system* system, size_t n_bodies, size_t n_points);
+/// add a body from 2n point coordinates with initial linear velocity
+/// (vx,vy). its mass is the current parameter "mass".
+RB_API int rb_add_body(rb_system* system, const float* points, size_t n,
+                       float vx, float vy);
+/// add `n_bodies` bodies at once: body i has counts[i] points, the 2 *
+/// counts[i] coordinates of all bodies follow each other in `points`.
+/// `velocities` holds (vx,vy) per body, or is NULL for bodies at rest. the
+/// memory is planned once for all bodies. fails without adding any body if
+/// a count is 0.
+RB_API int rb_add_bodies(rb_system* system, const float* points,
+                         const size_t* counts, size_t n_bodies,
+                         const float* velocities);
+
+/// set/get a parameter by name: gravity, linear_dynamics, angular_dynamics,
+/// body_collisions, aabb_tree, time_step, mass, damping, collision_damping,
+/// collision_elasticity, friction, solver_iterations (>= 1), warm_starting,
+/// contact_cache, threads (1..256), sleeping, sleep_velocity, sleep_time.
+/// set fails for values that are not finite and for integers out of range,
+/// get returns NaN for unknown names.
+RB_API int rb_set_parameter(rb_system* system, const char* name, float value);
+RB_API float rb_get_parameter(const rb_system* system, const char* name);
+
+/// perform `n` time steps
+RB_API void rb_step(rb_system* system, size_t n);
+
+/// number of bodies
+RB_API size_t rb_n_bodies(const rb_system* system);
+
+/// center of gravity and linear velocity of all bodies (2 components each)
+RB_API rb_view rb_positions(const rb_system* system);
+RB_API rb_view rb_linear_velocities(const rb_system* system);
+/// orientation and angular velocity of all bodies (1 component each)
+RB_API rb_view rb_orientations(const rb_system* system);
+RB_API rb_view rb_angular_velocities(const rb_system* system);
+/// world positions of the points of body i (contiguous, 2 components each)
+RB_API rb_view rb_body_points(const rb_system* system, size_t i);
+
+#ifdef __cplusplus
+}
+#endif
+
+//=============================================================================
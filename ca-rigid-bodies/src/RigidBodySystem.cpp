@@ -10,8 +10,9 @@
 
 #include "RigidBodySystem.h"
 #include "simple_shader.h"
-#include <float.h>
+#include <cfloat>
 #include <algorithm>
+#include <cmath>
 #include <chrono>
 #include <cstdlib>
 
@@ -27,13 +28,25 @@ vec3 random_color()
 
 //-----------------------------------------------------------------------------
 
-RigidBodySystem::RigidBodySystem()
+// pale version of `color` for sleeping bodies
+static vec3 sleeping_color(const vec3 &color)
 {
+    return 0.4 * color + vec3(0.6, 0.6, 0.6);
+}
+
+//-----------------------------------------------------------------------------
+
+RigidBodySystem::RigidBodySystem(bool use_opengl) : vertices_(&arena_)
+{
+    use_opengl_ = use_opengl;
     vertexArray_ = 0;
     pointBuffer_ = 0;
     edgeBuffer_ = 0;
     wallBuffer_ = 0;
     multiple_bodies_mode_ = false;
+    scene_ = 0;
+    step_ = 0;
+    n_sleeping_ = 0;
 
     reset_parameters();
 
@@ -51,6 +64,9 @@ RigidBodySystem::RigidBodySystem()
 
 RigidBodySystem::~RigidBodySystem()
 {
+    if (!use_opengl_)
+        return;
+
     glDeleteBuffers(1, &pointBuffer_);
     glDeleteBuffers(1, &edgeBuffer_);
     glDeleteBuffers(1, &wallBuffer_);
@@ -73,22 +89,84 @@ void RigidBodySystem::reset_parameters()
     mouse_spring_.active = false;
     collision_elasticity_ = 0.5;
     collision_damping_ = 2.0;
+    use_huge_pages_ = false;
+    use_aabb_tree_ = false;
+    use_contact_cache_ = true;
+    n_threads_ = 1;
+    use_sleeping_ = false;
+    sleep_velocity_ = 0.02;
+    sleep_time_ = 0.5;
+    friction_ = 0.5;
+    solver_iterations_ = 10;
+    use_warm_starting_ = true;
 }
 
 //-----------------------------------------------------------------------------
 
 void RigidBodySystem::clear_bodies()
 {
+    clear_bodies(0, 0);
+}
+
+//-----------------------------------------------------------------------------
+
+void RigidBodySystem::clear_bodies(unsigned int n_bodies,
+                                   unsigned int n_points)
+{
+    // vertex arrays of the bodies live in the arena, release them at once
     bodies_.clear();
+    vertices_.release();
+    sweep_and_prune_.clear();
+    aabb_tree_.clear();
+    solver_.clear();
+    manifolds_.clear();
+    n_sleeping_ = 0;
+    scene_ = 0;
+
+    // four vertex arrays (points, r, normals, local_normals) and the body
+    // index of all vertices
+    const size_t bytes =
+        4 * Arena::aligned_size(n_points * sizeof(vec2)) +
+        Arena::aligned_size(n_points * sizeof(int));
+    arena_.reserve(bytes, use_huge_pages_);
+    vertices_.reserve(n_points);
+    bodies_.reserve(n_bodies);
+
     update_opengl_buffers();
 }
 
 //-----------------------------------------------------------------------------
 
+void RigidBodySystem::reserve_bodies(unsigned int n_bodies,
+                                     unsigned int n_points)
+{
+    // the arena cannot grow without releasing the bodies, additional vertex
+    // memory comes from an overflow block
+    const bool grows = vertices_.size() + n_points > vertices_.capacity();
+    vertices_.reserve(vertices_.size() + n_points);
+    bodies_.reserve(bodies_.size() + n_bodies);
+
+    if (grows)
+        for (RigidBody &b : bodies_)
+            b.bind(vertices_);
+}
+
+//-----------------------------------------------------------------------------
+
 void RigidBodySystem::add_body(const std::vector<vec2> &points,
                                const vec2 linVelocity)
 {
-    bodies_.push_back(RigidBody(points, mass_, linVelocity));
+    const bool grows =
+        vertices_.size() + points.size() > vertices_.capacity();
+    bodies_.push_back(RigidBody(points, mass_, linVelocity, vertices_));
+    const RigidBody &b = bodies_.back();
+    std::fill(vertices_.body.begin() + b.offset, vertices_.body.end(),
+              (int)bodies_.size() - 1);
+
+    // any array of the pool may have moved, point the bodies to the new ones
+    if (grows)
+        for (RigidBody &b : bodies_)
+            b.bind(vertices_);
     update_opengl_buffers();
 }
 
@@ -96,29 +174,21 @@ void RigidBodySystem::add_body(const std::vector<vec2> &points,
 
 void RigidBodySystem::add_mouse_spring(const vec2 p)
 {
+    // the tree prunes bodies farther away than the closest point so far
     int idx = -1;
     int idb = -1;
-    float dmin = FLT_MAX;
-    for (size_t j = 0; j < bodies_.size(); j++)
-    {
-        RigidBody &b = bodies_[j];
-        for (size_t i = 0; i < b.points.size(); ++i)
-        {
-            float d = distance(p, b.points[i]);
-            if (d < dmin)
-            {
-                dmin = d;
-                idx = i;
-                idb = j;
-            }
-        }
-    }
+    aabb_tree_.update(bodies_);
+    aabb_tree_.closest_point(bodies_, p, idb, idx);
 
     mouse_spring_.active = true;
     mouse_spring_.body_index = idb;
     mouse_spring_.mouse_position = p;
     mouse_spring_.particle_index = idx;
 
+    // dragging wakes up the body's island
+    if (idb >= 0 && bodies_[idb].sleeping)
+        wake_island(idb);
+
     update_opengl_buffers();
 }
 
@@ -153,6 +223,9 @@ void RigidBodySystem::clear_mouse_spring()
 
 void RigidBodySystem::update_opengl_buffers()
 {
+    if (!use_opengl_)
+        return;
+
     // generate buffers
     if (!vertexArray_)
     {
@@ -166,26 +239,20 @@ void RigidBodySystem::update_opengl_buffers()
     }
     glBindVertexArray(vertexArray_);
 
-    int n = 0;
-    for (const RigidBody &body : bodies_)
-    {
-        n += body.points.size();
-    }
+    const int n = vertices_.size();
 
-    // particle positions
-    std::vector<vec2> pos;
-    pos.reserve(n);
-    for (const RigidBody &body : bodies_)
-    {
-        pos.insert(pos.end(), body.points.begin(), body.points.end());
-    }
+    // particle positions, the pool stores them in the order of the bodies.
+    // the mouse position follows them.
+    glBindBuffer(GL_ARRAY_BUFFER, pointBuffer_);
+    glBufferData(GL_ARRAY_BUFFER, (n + 1) * sizeof(vec2), nullptr,
+                 GL_DYNAMIC_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, n * sizeof(vec2),
+                    vertices_.points.data());
     if (mouse_spring_.active)
     {
-        pos.push_back(mouse_spring_.mouse_position);
+        glBufferSubData(GL_ARRAY_BUFFER, n * sizeof(vec2), sizeof(vec2),
+                        mouse_spring_.mouse_position.data());
     }
-    glBindBuffer(GL_ARRAY_BUFFER, pointBuffer_);
-    glBufferData(GL_ARRAY_BUFFER, pos.size() * sizeof(vec2), pos.data(),
-                 GL_DYNAMIC_DRAW);
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0);
     glEnableVertexAttribArray(0);
 
@@ -330,7 +397,9 @@ void RigidBodySystem::draw(const mat4 &projection)
         int offset = 0;
         for (int i = 0; i < bodies_.size(); ++i)
         {
-            shader_.set_uniform("color", bodies_[i].color);
+            const RigidBody &b = bodies_[i];
+            shader_.set_uniform("color", b.sleeping ? sleeping_color(b.color)
+                                                    : b.color);
             const int n = (bodies_[i].points.size() - 2) * 3;
             glDrawElements(GL_TRIANGLES, n, GL_UNSIGNED_INT,
                            (void *)(offset * sizeof(GLuint)));
@@ -344,6 +413,56 @@ void RigidBodySystem::draw(const mat4 &projection)
 
 //-----------------------------------------------------------------------------
 
+void RigidBodySystem::rasterize(Rasterizer &rasterizer) const
+{
+    rasterizer.clear(vec3(1, 1, 1));
+
+    // walls, as band between the box and a slightly larger one
+    const float d0 =
+        multiple_bodies_mode_ ? 1.0 + 1e-3 - particle_radius_ : 1.0;
+    const float d1 = 1.1;
+    for (int i = 0; i < 4; ++i)
+    {
+        const vec2 p0 = walls_[i].p0, p1 = walls_[(i + 1) % 4].p0;
+        rasterizer.fill_triangle(d0 * p0, d1 * p0, d1 * p1,
+                                 vec3(0.5, 0.5, 0.5));
+        rasterizer.fill_triangle(d0 * p0, d1 * p1, d0 * p1,
+                                 vec3(0.5, 0.5, 0.5));
+    }
+
+    for (const RigidBody &b : bodies_)
+    {
+        const int n = b.points.size();
+
+        // filled bodies (fan triangulation)
+        if (multiple_bodies_mode_)
+            for (int k = 1; k + 1 < n; ++k)
+                rasterizer.fill_triangle(
+                    b.points[0], b.points[k], b.points[k + 1],
+                    b.sleeping ? sleeping_color(b.color) : b.color);
+
+        // edges
+        for (int k = 0; k < n; ++k)
+            rasterizer.draw_line(b.points[k], b.points[(k + 1) % n], 1.0,
+                                 vec3(0, 0, 0));
+
+        // points
+        if (!multiple_bodies_mode_)
+            for (const vec2 &p : b.points)
+                rasterizer.fill_disc(p, particle_radius_, vec3(0, 1, 0));
+    }
+
+    if (mouse_spring_.active)
+    {
+        const RigidBody &b = bodies_[mouse_spring_.body_index];
+        rasterizer.draw_line(b.points[mouse_spring_.particle_index],
+                             mouse_spring_.mouse_position, 1.0,
+                             vec3(0, 0, 0));
+    }
+}
+
+//-----------------------------------------------------------------------------
+
 void RigidBodySystem::compute_forces()
 {
     // clear forces
@@ -360,6 +479,8 @@ void RigidBodySystem::compute_forces()
      */
     for (auto &b : bodies_)
     {
+        if (b.sleeping)
+            continue;
         if (use_gravity_) {
             b.force += vec2(0.0, -9.81) * b.mass;
         }
@@ -392,216 +513,513 @@ void RigidBodySystem::compute_forces()
 
 void RigidBodySystem::time_integration()
 {
+    ScopedTimer step_timer(profiler_, "step");
+
     float dt = time_step_;
 
-    // compute all forces
+    // (re)start the workers if the number of threads has changed
+    if (n_threads_ < 2)
+        pool_.reset();
+    else if (!pool_ || (int)pool_->size() != n_threads_)
+        pool_.reset(new ThreadPool(n_threads_));
+
+    // find the pairs of touching bodies. islands woken up by them take part
+    // in the whole step: they receive forces, and the second broadphase
+    // pass reports the pairs inside them, which it skipped while they slept.
+    update_broadphase();
+    ++step_;
+    if (n_sleeping_ && wake_touched_islands())
+        update_broadphase();
+
+    // compute all forces and update velocities first (semi-implicit Euler),
+    // such that the contact solver corrects the new velocities
+    ScopedTimer forces_timer(profiler_, "forces");
     compute_forces();
+    for (auto &b : bodies_)
+    {
+        if (b.sleeping)
+            continue;
+        if (use_linear_dynamics_)
+            b.linear_velocity += dt * b.force / b.mass;
+        if (use_angular_dynamics_)
+            b.angular_velocity += dt * b.torque / b.inertia;
+    }
+    forces_timer.stop();
 
-    // handle body-wall collisions
+    // collect body-wall and body-body contacts and solve them
+    ScopedTimer collisions_timer(profiler_, "collisions");
+    solver_.begin_step();
     handle_wall_collisions();
-
-    // handle body-body collisions
     handle_body_collisions();
-
-    // update positions and velocities
-    for (auto &b : bodies_)
-    {
-        if (use_linear_dynamics_) {
-            b.position += dt * b.linear_velocity;
-            b.linear_velocity += dt * b.force / b.mass; // b.mass^-1 * b.force =^= M^-1*F
+    collisions_timer.stop();
+
+    ScopedTimer solver_timer(profiler_, "solver");
+    solver_.iterations = solver_iterations_;
+    solver_.friction = friction_;
+    solver_.restitution = collision_elasticity_;
+    solver_.warm_starting = use_warm_starting_;
+    solver_.linear = use_linear_dynamics_;
+    solver_.angular = use_angular_dynamics_;
+    solver_.solve(bodies_, dt, pool_.get());
+    solver_timer.stop();
+
+    // update positions with the corrected velocities
+    ScopedTimer integration_timer(profiler_, "integration");
+    const int n_bodies = bodies_.size();
+    angles_.resize(n_bodies);
+    sines_.resize(n_bodies);
+    cosines_.resize(n_bodies);
+    centers_.resize(n_bodies);
+    auto integrate = [this, dt](int begin, int end) {
+        for (int i = begin; i < end; ++i)
+        {
+            RigidBody &b = bodies_[i];
+            if (!b.sleeping)
+            {
+                if (use_linear_dynamics_)
+                    b.position += dt * b.linear_velocity;
+                if (use_angular_dynamics_)
+                    b.orientation += dt * b.angular_velocity;
+            }
+            angles_[i] = b.orientation;
+            centers_[i] = b.position;
         }
 
-        if (use_angular_dynamics_) {
-            b.orientation += dt * b.angular_velocity;
-            b.angular_velocity += dt * b.torque / b.inertia;
+        // rotations of all bodies in one vectorized pass instead of a sin
+        // and cos per body
+        batch_sincos(&angles_[begin], &sines_[begin], &cosines_[begin],
+                     end - begin);
+
+        // transform the vertices of consecutive awake bodies in one loop
+        for (int first = begin, last; first < end; first = last + 1)
+        {
+            while (first < end && bodies_[first].sleeping)
+                ++first;
+            for (last = first; last < end && !bodies_[last].sleeping; ++last)
+                ;
+            if (first < last)
+            {
+                const RigidBody &b = bodies_[last - 1];
+                vertices_.transform(bodies_[first].offset,
+                                    b.offset + b.points.size(),
+                                    centers_.data(), cosines_.data(),
+                                    sines_.data());
+            }
         }
 
-        /** \todo To implement explicit Euler time integration: done!
-         * - Update position and orientation
-         * - Update linear and angular velocities
-         * - Optional: To make use of the GUI checkboxes, update linear parameters only
-         *   if use_linear_dynamics_==true and angular ones if use_angular_dynamics_==true
-         * - Hint: The class RigidBody stores all information needed for time-stepping
-         */
+        for (int i = begin; i < end; ++i)
+            if (!bodies_[i].sleeping)
+                bodies_[i].update_box();
+    };
 
-        // update particle position after updating body position and orientation
-        b.update_points();
+    // integrate in chunks that stay in the cache between the passes above.
+    // bodies are independent, the pool integrates the chunks in parallel.
+    const int chunk = 1024;
+    for (int begin = 0; begin < n_bodies; begin += chunk)
+    {
+        const int end = std::min(begin + chunk, n_bodies);
+        if (pool_)
+            pool_->submit(
+                [&integrate, begin, end]() { integrate(begin, end); });
+        else
+            integrate(begin, end);
     }
+    if (pool_)
+        pool_->wait();
+    integration_timer.stop();
+    const bool moved = n_sleeping_ < bodies_.size();
 
-    // update OpenGL buffer for rendering
-    update_opengl_buffers();
+    // deactivate resting and wake up disturbed islands
+    if (use_sleeping_)
+    {
+        ScopedTimer sleeping_timer(profiler_, "sleeping");
+        update_sleeping(dt);
+    }
+    else if (n_sleeping_)
+    {
+        wake_up();
+    }
+
+    // update OpenGL buffer for rendering, unless nothing has moved
+    ScopedTimer upload_timer(profiler_, "upload");
+    if (moved)
+        update_opengl_buffers();
 }
 
 //-----------------------------------------------------------------------------
 
 void RigidBodySystem::handle_wall_collisions()
 {
-    for (auto &b : bodies_)
+    for (int i = 0; i < (int)bodies_.size(); ++i)
     {
-        vec2 collision_point = vec2(0.0, 0.0);
-        float collision_count = 0.0;
-        vec2 collision_normal = vec2(0.0, 0.0);
-
-        for (auto &p : b.points) {
-            for (auto &w : walls_) {
-                if (dot(p - w.p0, w.normal) < 0.0) {
-                    collision_count++;
-                    collision_point += p;
-                    collision_normal += w.normal;
-                }
-            }
-        }
-        if (collision_count == 0.0) continue;
-        collision_point /= collision_count;
-        collision_normal /= collision_count;
-        collision_normal = normalize(collision_normal);
+        const RigidBody &b = bodies_[i];
+        if (b.sleeping)
+            continue;
 
-        vec2 r_body_p = perp(collision_point - b.position);
-        double v_rel = dot(collision_normal, b.linear_velocity + b.angular_velocity * r_body_p);
+        const vec2 center = 0.5 * (b.box_min + b.box_max);
+        const vec2 extent = 0.5 * (b.box_max - b.box_min);
 
-        if (v_rel < 0.0) { // colliding contact
-            double w_body = 1/b.mass + dot(collision_normal, dot(collision_normal, r_body_p) * r_body_p)/b.inertia;
-            double j = -(1 + collision_elasticity_) * v_rel/w_body;
+        for (int k = 0; k < (int)walls_.size(); ++k)
+        {
+            const Wall &w = walls_[k];
 
-            b.linear_velocity += j * collision_normal / b.mass;
-            b.angular_velocity += dot(j * collision_normal, r_body_p) / b.inertia;
-        }
+            // skip walls the bounding box does not reach
+            const float d = dot(center - w.p0, w.normal) -
+                            std::fabs(w.normal[0]) * extent[0] -
+                            std::fabs(w.normal[1]) * extent[1];
+            if (d >= 0.0)
+                continue;
 
-        /**
-         * \todo Handle collisions of body `b` and walls `walls_` based on impulses.
-         * - Find out whether a rigid body is (partially) inside a wall
-         * - Resolve collisions based on impulses if we have a colliding contact
-         * - Hints:
-         *      - The class `Wall` stores the data required for computing collisions
-         *      - If you have more than one colliding point per body (e.g edge collision),
-         *        handling all points individually will give the wrong result.
-         *        Instead, compute the average collision point in this case.
-         *      - You can use `perp(e)` to rotate a `vec2 e` by 90 degrees
-         *        (in counter-clockwise order) to get a perpendicular vector
-         *      - Since the wall does not move, compute v_rel only based on rigid body
-         */
+            // each point behind the wall is a contact
+            for (int j = 0; j < (int)b.points.size(); ++j)
+            {
+                const float depth = -dot(b.points[j] - w.p0, w.normal);
+                if (depth > 0.0)
+                    solver_.add_contact(i, -1, (k << 16) | j, b.points[j],
+                                        w.normal, depth);
+            }
+        }
     }
 }
 
 //-----------------------------------------------------------------------------
 
-void RigidBodySystem::handle_body_collisions()
+void RigidBodySystem::update_broadphase()
 {
-    vec2 collision_point, collision_normal;
+    ScopedTimer broadphase_timer(profiler_, "broadphase");
+    if (use_aabb_tree_)
+    {
+        aabb_tree_.update(bodies_);
+        aabb_tree_.find_pairs();
+    }
+    else
+    {
+        sweep_and_prune_.update(bodies_);
+    }
+}
 
-    for (unsigned int i = 0; i < bodies_.size(); i++)
+//-----------------------------------------------------------------------------
+
+bool RigidBodySystem::wake_touched_islands()
+{
+    Manifold manifold;
+    bool woken = false;
+    for (const std::pair<int, int> &pair : broadphase_pairs())
     {
-        for (unsigned int j = i + 1; j < bodies_.size(); j++)
+        const RigidBody &b1 = bodies_[pair.first];
+        const RigidBody &b2 = bodies_[pair.second];
+        if (b1.sleeping != b2.sleeping &&
+            find_manifold(pair.first, pair.second, manifold))
         {
-            RigidBody &b1 = bodies_[i];
-            RigidBody &b2 = bodies_[j];
-
-            if (detect_collision(b1, b2, collision_point, collision_normal))
-            {
-                resolve_collision(b1, b2, collision_point, collision_normal);
-            }
+            wake_island(b1.sleeping ? pair.first : pair.second);
+            woken = true;
         }
     }
+    return woken;
 }
 
 //-----------------------------------------------------------------------------
 
-bool RigidBodySystem::detect_collision(RigidBody &b1, RigidBody &b2,
-                                       vec2 &collision_point,
-                                       vec2 &collision_normal)
+void RigidBodySystem::handle_body_collisions()
 {
-    collision_point = vec2(0, 0);
-    collision_normal = vec2(0, 0);
-    int counter = 0;
-    std::vector<vec2> samples;
-    vec2 n;
+    Manifold manifold;
+
+    // pairs of sleeping bodies are not reported, they do not move and their
+    // contacts need no update
+    const std::vector<std::pair<int, int>> &pairs = broadphase_pairs();
 
-    // collect vertices and edge midpoints of first body and test them against second body
-    samples = b1.points;
-    for (int i = 0, N = b1.points.size(); i < N; i++)
+    for (const std::pair<int, int> &pair : pairs)
     {
-        samples.push_back(0.5 * (b1.points[i] + b1.points[(i + 1) % N]));
+        RigidBody &b1 = bodies_[pair.first];
+        RigidBody &b2 = bodies_[pair.second];
+
+        if (find_manifold(pair.first, pair.second, manifold))
+        {
+            for (int k = 0; k < manifold.n_points; ++k)
+                solver_.add_contact(pair.first, pair.second, manifold.ids[k],
+                                    manifold.points[k], manifold.normal,
+                                    manifold.depths[k]);
+
+            // visualize impacts (not resting contacts) by changing color
+            const vec2 &p = manifold.points[0];
+            const vec2 v1 = b1.linear_velocity +
+                            b1.angular_velocity * perp(p - b1.position);
+            const vec2 v2 = b2.linear_velocity +
+                            b2.angular_velocity * perp(p - b2.position);
+            if (dot(v1 - v2, manifold.normal) < -0.1)
+            {
+                b1.color = random_color();
+                b2.color = random_color();
+            }
+        }
     }
-    for (auto p : samples)
+
+    // forget the pairs the broadphase has not reported in this step
+    if (manifolds_.size() > pairs.size())
     {
-        if (is_point_in_body(p, b2, n))
+        for (auto it = manifolds_.begin(); it != manifolds_.end();)
         {
-            collision_point += p;
-            collision_normal += n;
-            counter++;
+            if (it->second.step != step_)
+                it = manifolds_.erase(it);
+            else
+                ++it;
         }
     }
+}
 
-    // collect vertices and edge midpoints of second body and test them against first body
-    samples = b2.points;
-    for (int i = 0, N = b2.points.size(); i < N; i++)
+//-----------------------------------------------------------------------------
+
+void RigidBodySystem::update_sleeping(float dt)
+{
+    const int n_islands = solver_.n_islands();
+    const float v_max = sleep_velocity_;
+    const int mouse_body =
+        mouse_spring_.active ? mouse_spring_.body_index : -1;
+
+    // resting times of awake bodies, the shortest one of each island
+    island_rest_.assign(n_islands, FLT_MAX);
+    island_first_.assign(n_islands, -1);
+    for (int i = 0; i < (int)bodies_.size(); ++i)
     {
-        samples.push_back(0.5 * (b2.points[i] + b2.points[(i + 1) % N]));
+        RigidBody &b = bodies_[i];
+        if (b.sleeping)
+            continue;
+
+        // the fastest point of the body is slower than v_max
+        const bool resting = norm(b.linear_velocity) +
+                                     std::fabs(b.angular_velocity) * b.radius <
+                                 v_max &&
+                             i != mouse_body;
+        b.rest_time = resting ? b.rest_time + dt : 0.0f;
+
+        const int island = solver_.island(i);
+        island_rest_[island] = std::min(island_rest_[island], b.rest_time);
+        if (island_first_[island] < 0)
+            island_first_[island] = i;
     }
-    for (auto p : samples)
+
+    // islands fall asleep as a whole
+    for (int i = 0; i < (int)bodies_.size(); ++i)
     {
-        if (is_point_in_body(p, b1, n))
+        RigidBody &b = bodies_[i];
+        const int island = solver_.island(i);
+        if (b.sleeping || island_rest_[island] < sleep_time_)
+            continue;
+
+        b.sleeping = true;
+        b.sleep_island = island_first_[island];
+        b.linear_velocity = vec2(0, 0);
+        b.angular_velocity = 0.0;
+        ++n_sleeping_;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void RigidBodySystem::wake_island(int body)
+{
+    const int island = bodies_[body].sleep_island;
+    for (RigidBody &b : bodies_)
+    {
+        if (b.sleeping && b.sleep_island == island)
         {
-            collision_point += p;
-            collision_normal -= n;
-            counter++;
+            b.sleeping = false;
+            b.rest_time = 0.0;
+            --n_sleeping_;
         }
     }
+}
+
+//-----------------------------------------------------------------------------
 
-    // if there is at least one collision -> find average collision point and normal
-    if (counter > 0)
+void RigidBodySystem::wake_up()
+{
+    for (RigidBody &b : bodies_)
     {
-        // visualize collision by changing color of both bodies
-        b1.color = random_color();
-        b2.color = random_color();
+        b.sleeping = false;
+        b.rest_time = 0.0;
+    }
+    n_sleeping_ = 0;
+}
 
-        // average collision point and normal
-        collision_point /= (float)counter;
-        collision_normal.normalize();
+//-----------------------------------------------------------------------------
 
+// rotate `v` by the angle with cosine `c` and sine `s`
+static inline vec2 rotate(const vec2 &v, float c, float s)
+{
+    return vec2(c * v[0] - s * v[1], s * v[0] + c * v[1]);
+}
+
+bool RigidBodySystem::find_manifold(int i, int j, Manifold &manifold)
+{
+    // largest motion of the points of two bodies relative to each other for
+    // which their manifold is reused, small against the solver's slop
+    static const float tolerance = 1e-4;
+
+    const RigidBody &b1 = bodies_[i];
+    const RigidBody &b2 = bodies_[j];
+    if (!use_contact_cache_)
+        return detect_collision(b1, b2, manifold);
+
+    // pose of b1 in the frame of b2
+    const float c = cos(b2.orientation), s = sin(b2.orientation);
+    const vec2 offset = rotate(b1.position - b2.position, c, -s);
+    const float angle = b1.orientation - b2.orientation;
+
+    const uint64_t key = ((uint64_t)i << 32) | (uint32_t)j;
+    auto it = manifolds_.find(key);
+    if (it != manifolds_.end() &&
+        norm(offset - it->second.offset) +
+                std::fabs(angle - it->second.angle) * b1.radius <
+            tolerance)
+    {
+        // same relative pose as before: transform the cached manifold
+        CachedManifold &cached = it->second;
+        cached.step = step_;
+        if (!cached.colliding)
+            return false;
+
+        manifold = cached.manifold;
+        manifold.normal = rotate(manifold.normal, c, s);
+        for (int k = 0; k < manifold.n_points; ++k)
+            manifold.points[k] =
+                rotate(manifold.points[k], c, s) + b2.position;
         return true;
     }
 
-    return false;
+    // collision test from scratch, store the result in the frame of b2
+    CachedManifold &cached = manifolds_[key];
+    cached.offset = offset;
+    cached.angle = angle;
+    cached.step = step_;
+    cached.colliding = detect_collision(b1, b2, manifold);
+    if (cached.colliding)
+    {
+        cached.manifold = manifold;
+        cached.manifold.normal = rotate(manifold.normal, c, -s);
+        for (int k = 0; k < manifold.n_points; ++k)
+            cached.manifold.points[k] =
+                rotate(manifold.points[k] - b2.position, c, -s);
+    }
+    return cached.colliding;
 }
 
 //-----------------------------------------------------------------------------
 
-bool RigidBodySystem::is_point_in_body(const vec2 &p, const RigidBody &body,
-                                       vec2 &normal)
+// largest separation of body `b` from an edge of body `a`, and the edge
+// where it is attained. stops at the first separating edge.
+static float max_separation(const RigidBody &a, const RigidBody &b, int &edge)
 {
-    // THIS PART ASSUMES THAT THE RIGID BODY IS CONVEX
-
-    /**
-     * \todo Test whether point `p` is inside the convex object `body` and store the collision normal in `normal`.
-     * Return true in case of a collision. 
-     * Compute the signed distance to each (infinite line containing an) edge of the body. 
-     * If `p` is inside with respect to each edge, there is a collision.
-     *
-     * Hints:
-     * 1. You can compute the normal direction of each edge, defined by points `p1` and `p2`, via `n = perp(p1 - p2)`
-     * 2. The collision normal is the normal of the closest edge to `p`.
-     * 
-     * Note: The code assumes that the rigid body is convex!
-     */
+    float max_separation = -FLT_MAX;
+    edge = 0;
+    for (int i = 0, n = a.points.size(); i < n; ++i)
+    {
+        float separation = FLT_MAX;
+        for (const vec2 &q : b.points)
+            separation =
+                std::min(separation, dot(a.normals[i], q - a.points[i]));
 
+        if (separation > max_separation)
+        {
+            max_separation = separation;
+            edge = i;
+            if (separation > 0.0)
+                break;
+        }
+    }
+    return max_separation;
+}
 
-    return false;
+// clip segment `v` to the half plane dot(normal, x) <= offset
+static int clip_segment(vec2 v[2], unsigned int ids[2], const vec2 &normal,
+                        float offset, unsigned int clip_id)
+{
+    const float d0 = dot(normal, v[0]) - offset;
+    const float d1 = dot(normal, v[1]) - offset;
+
+    // both inside, or both outside
+    if (d0 <= 0.0 && d1 <= 0.0)
+        return 2;
+    if (d0 > 0.0 && d1 > 0.0)
+        return 0;
+
+    // replace the outside endpoint by the intersection
+    const int k = d0 > 0.0 ? 0 : 1;
+    v[k] = v[0] + (d0 / (d0 - d1)) * (v[1] - v[0]);
+    ids[k] = clip_id;
+    return 2;
 }
 
 //-----------------------------------------------------------------------------
 
-void RigidBodySystem::resolve_collision(RigidBody &b1, RigidBody &b2,
-                                        const vec2 &collision_point,
-                                        const vec2 &collision_normal)
+bool RigidBodySystem::detect_collision(const RigidBody &b1,
+                                       const RigidBody &b2,
+                                       Manifold &manifold) const
 {
-    /**
-     * \todo Handle impulse-based object-object collisions:
-     * - Check the relative velocity to make sure that the objects do not already separate
-     * - If there is a colliding collision, set `colliding=true` to trigger the object explosions.
-     * - Apply the impulse-based collision response to both bodies.
-     */
+    manifold.n_points = 0;
+
+    // separating axis test with the edge normals of both bodies
+    int edge1, edge2;
+    const float separation1 = max_separation(b1, b2, edge1);
+    if (separation1 > 0.0)
+        return false;
+    const float separation2 = max_separation(b2, b1, edge2);
+    if (separation2 > 0.0)
+        return false;
+
+    // reference edge of least penetration, prefer b1 for coherence
+    const bool flip = separation2 > 0.98 * separation1 + 1e-4;
+    const RigidBody &ref = flip ? b2 : b1;
+    const RigidBody &inc = flip ? b1 : b2;
+    const int edge = flip ? edge2 : edge1;
+    const vec2 normal = ref.normals[edge];
+
+    // incident edge: the edge of the other body most opposed to the normal
+    int incident = 0;
+    float min_dot = FLT_MAX;
+    for (int i = 0, n = inc.normals.size(); i < n; ++i)
+    {
+        const float d = dot(normal, inc.normals[i]);
+        if (d < min_dot)
+        {
+            min_dot = d;
+            incident = i;
+        }
+    }
+
+    // feature ids: reference edge, incident vertex or clipping side, flip
+    const unsigned int ref_id = (edge << 16) | (flip ? 1 : 0);
+    const int i0 = incident, i1 = (incident + 1) % inc.points.size();
+    vec2 v[2] = {inc.points[i0], inc.points[i1]};
+    unsigned int ids[2] = {ref_id | (i0 << 2), ref_id | (i1 << 2)};
+
+    // clip the incident edge to the side planes of the reference edge
+    const vec2 &r0 = ref.points[edge];
+    const vec2 &r1 = ref.points[(edge + 1) % ref.points.size()];
+    const vec2 tangent = normalize(r1 - r0);
+    if (clip_segment(v, ids, -tangent, -dot(tangent, r0), ref_id | 2) < 2 ||
+        clip_segment(v, ids, tangent, dot(tangent, r1), ref_id | 6) < 2)
+        return false;
+
+    // keep the points behind the reference edge, halfway to the edge
+    for (int k = 0; k < 2; ++k)
+    {
+        const float separation = dot(normal, v[k] - r0);
+        if (separation <= 0.0)
+        {
+            const int i = manifold.n_points++;
+            manifold.points[i] = v[k] - 0.5 * separation * normal;
+            manifold.depths[i] = -separation;
+            manifold.ids[i] = ids[k];
+        }
+    }
+    if (manifold.n_points == 0)
+        return false;
+
+    // normal of the reference edge points away from the reference body
+    manifold.normal = flip ? normal : -normal;
 
+    return true;
 }
 
 //=============================================================================
@@ -12,12 +12,21 @@
 
 #include "RigidBody.h"
 #include "Sphere.h"
+#include "Profiler.h"
+#include "Rasterizer.h"
+#include "SweepAndPrune.h"
+#include "AABBTree.h"
+#include "ContactSolver.h"
+#include "ThreadPool.h"
 
 #include <pmp/Shader.h>
 using namespace pmp;
 
 #include <vector>
 #include <set>
+#include <unordered_map>
+#include <cstdint>
+#include <memory>
 
 //== CLASS DEFINITION =========================================================
 
@@ -27,8 +36,9 @@ Class for managing and simulating rigid bodies.
 class RigidBodySystem
 {
 public:
-    /// Constructor
-    RigidBodySystem();
+    /// Constructor. without OpenGL the system is simulated headless, i.e.,
+    /// it does not create buffers and cannot be drawn.
+    RigidBodySystem(bool use_opengl = true);
     /// Destructor
     ~RigidBodySystem();
 
@@ -40,10 +50,20 @@ public:
                   const vec2 linVelocity = vec2(0, 0));
     /// Remove all rigid bodies
     void clear_bodies();
+    /// Remove all rigid bodies and plan the memory for a scene with the
+    /// given number of bodies and points
+    void clear_bodies(unsigned int n_bodies, unsigned int n_points);
+    /// Plan the memory for `n_bodies` more bodies with `n_points` points in
+    /// total, such that adding them moves the vertex pool at most once
+    void reserve_bodies(unsigned int n_bodies, unsigned int n_points);
 
     /// Render the rigid bodies
     void draw(const pmp::mat4 &projection);
 
+    /// Render the rigid bodies into the framebuffer of `rasterizer`, which
+    /// works without OpenGL (e.g. for headless video export)
+    void rasterize(Rasterizer &rasterizer) const;
+
     /// Perform one time step
     void time_integration();
 
@@ -56,30 +76,63 @@ public:
     /// Is mouse spring active?
     bool is_mouse_spring_active() const;
 
+    /// wake up all sleeping bodies (e.g. after parameters have changed)
+    void wake_up();
+
+    /// number of sleeping bodies
+    unsigned int n_sleeping() const { return n_sleeping_; }
+
+public:
+    /// contact manifold of two colliding bodies b1 and b2
+    struct Manifold
+    {
+        vec2 normal;         ///< contact normal (pointing from b2 towards b1)
+        int n_points;        ///< number of contact points (1 or 2)
+        vec2 points[2];      ///< contact points
+        float depths[2];     ///< penetration depths
+        unsigned int ids[2]; ///< features defining the contact points
+    };
+
 private: //--- internal functions --------------------------------------------
     /// Compute all forces
     void compute_forces();
 
-    /// Handle body-wall collisions
+    /// Collect the contacts of bodies and walls for the solver
     void handle_wall_collisions();
 
-    /// Handle body-body collisions
-    /// Calls `object_object_collisions` for collision detection and response
+    /// Find the pairs of bodies with overlapping bounding boxes by sweep
+    /// and prune or the AABB tree. Pairs of sleeping bodies are skipped.
+    void update_broadphase();
+
+    /// pairs found by the last update_broadphase()
+    const std::vector<std::pair<int, int>> &broadphase_pairs() const
+    {
+        return use_aabb_tree_ ? aabb_tree_.pairs() : sweep_and_prune_.pairs();
+    }
+
+    /// Wake up the islands of sleeping bodies that awake bodies touch.
+    /// Returns whether an island has woken up.
+    bool wake_touched_islands();
+
+    /// Collect the contacts between bodies for the solver. Only the pairs
+    /// of the broadphase are passed to `find_manifold`.
     void handle_body_collisions();
 
-    /// Determine whether body `b1` is colliding with body `b2`.
-    /// Return collision point and collision normal via references.
-    bool detect_collision(RigidBody &b1, RigidBody &b2, vec2 &collision_point,
-                          vec2 &collision_normal);
+    /// Contact manifold of bodies `i` < `j`. Reuses the manifold of the
+    /// previous step if the bodies have (almost) not moved relative to each
+    /// other, calls `detect_collision` otherwise.
+    bool find_manifold(int i, int j, Manifold &manifold);
 
-    /// Impulse-based collisions response for body-body collisions
-    void resolve_collision(RigidBody &b1, RigidBody &b2,
-                           const vec2 &collidingPoint,
-                           const vec2 &collisionNormal);
+    /// put islands to sleep whose bodies all rested for sleep_time_
+    void update_sleeping(float dt);
 
-    /// Test whether a point `p` is inside a rigid object of a square `body`.
-    /// Store the collision normal (normal of nearest edge) in `normal`
-    bool is_point_in_body(const vec2 &p, const RigidBody &body, vec2 &normal);
+    /// wake up the island `body` fell asleep with
+    void wake_island(int body);
+
+    /// Determine whether the convex bodies `b1` and `b2` are colliding by
+    /// the separating axis test. Return the contact manifold via reference.
+    bool detect_collision(const RigidBody &b1, const RigidBody &b2,
+                          Manifold &manifold) const;
 
 public: //--- parameters -----------------------------------------------------
     /// radius of particles (for rendering and collisions)
@@ -106,6 +159,33 @@ public: //--- parameters -----------------------------------------------------
     float spring_damping_;
     /// how much velocity will be decreased after collision
     float collision_elasticity_;
+    /// Coulomb friction coefficient of contacts
+    float friction_;
+    /// iterations of the contact solver
+    int solver_iterations_;
+    /// start the contact solver from the impulses of the previous step
+    bool use_warm_starting_;
+
+    /// back large scenes by huge pages (Linux only)
+    bool use_huge_pages_;
+    /// use the AABB tree instead of sweep-and-prune as broadphase
+    bool use_aabb_tree_;
+    /// reuse the contact manifolds of pairs at rest relative to each other
+    bool use_contact_cache_;
+    /// threads for solving islands and integrating bodies (1: sequential)
+    int n_threads_;
+    /// deactivate resting islands of bodies
+    bool use_sleeping_;
+    /// bodies whose points are slower than this are resting
+    float sleep_velocity_;
+    /// time an island has to rest before it falls asleep
+    float sleep_time_;
+
+private:
+    /// memory of the vertex arrays of all rigid bodies
+    Arena arena_;
+    /// vertices of all rigid bodies, in the order of the bodies
+    VertexPool vertices_;
 
 public: //--- simulation data ------------------------------------------------
     /// the rigid bodies to be simulated
@@ -123,6 +203,51 @@ public: //--- simulation data ------------------------------------------------
     /// whether we are in multiple bodies mode (key 4)
     bool multiple_bodies_mode_;
 
+    /// built-in scene set up by setup_scene(), 0 for other bodies
+    int scene_;
+
+    /// broadphases for body-body collisions
+    SweepAndPrune sweep_and_prune_;
+    AABBTree aabb_tree_;
+
+    /// sequential impulse solver for all contacts
+    ContactSolver solver_;
+
+    /// result of the collision test of a pair of bodies b1 and b2, in the
+    /// local frame of b2
+    struct CachedManifold
+    {
+        vec2 offset;       ///< position of b1 in the frame of b2
+        float angle;       ///< orientation of b1 relative to b2
+        bool colliding;    ///< whether the bodies collide
+        Manifold manifold; ///< contact manifold in the frame of b2
+        unsigned int step; ///< last step the pair has been tested in
+    };
+    /// cached manifolds of the pairs of the broadphase, keyed by (i << 32 | j)
+    std::unordered_map<uint64_t, CachedManifold> manifolds_;
+    /// counts the calls of handle_body_collisions()
+    unsigned int step_;
+
+    /// timings of the phases of time_integration()
+    Profiler profiler_;
+
+private:
+    /// workers for the solver and the integration, started if n_threads_ > 1
+    std::unique_ptr<ThreadPool> pool_;
+
+    /// number of sleeping bodies
+    unsigned int n_sleeping_;
+    /// shortest resting time and first body of each island
+    std::vector<float> island_rest_;
+    std::vector<int> island_first_;
+
+    /// orientations, their sines and cosines, and positions of the bodies,
+    /// contiguous for the batched transform of the vertices
+    std::vector<float> angles_;
+    std::vector<float> sines_;
+    std::vector<float> cosines_;
+    std::vector<vec2> centers_;
+
 private:
     /// the interactive spring controlled by the mouse
     struct
@@ -141,6 +266,9 @@ private: //--- OpenGL rendering ----------------------------------------------
     /// send all data that should be drawn to the GPU
     void update_opengl_buffers();
 
+    /// use OpenGL for rendering? (false for headless simulations)
+    bool use_opengl_;
+
     Shader shader_;
     Sphere sphere_;
 
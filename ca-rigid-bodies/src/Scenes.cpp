@@ -0,0 +1,158 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+
+#include "Scenes.h"
+
+#include <vector>
+
+//== IMPLEMENTATION ==========================================================
+
+bool setup_scene(RigidBodySystem& simulation, int scene)
+{
+    if (scene < 1 || scene > n_scenes)
+        return false;
+
+    // leaving scene 4: restore the parameters it has changed. restarting a
+    // scene keeps the parameters.
+    const int previous = simulation.scene_;
+
+    switch (scene)
+    {
+        // setup problem 1
+        case 1:
+        {
+            simulation.clear_bodies(1, 4);
+
+            std::vector<vec2> p;
+            p.push_back(vec2(-0.6, -0.6));
+            p.push_back(vec2(-0.4, -0.6));
+            p.push_back(vec2(-0.4, -0.4));
+            p.push_back(vec2(-0.6, -0.4));
+            simulation.add_body(p);
+            simulation.multiple_bodies_mode_ = false;
+            break;
+        }
+
+        // setup problem 2
+        case 2:
+        {
+            simulation.clear_bodies(1, 8);
+
+            std::vector<vec2> p;
+            p.push_back(vec2(-0.3, -0.1));
+            p.push_back(vec2(-0.1, -0.1));
+            p.push_back(vec2(0.1, -0.1));
+            p.push_back(vec2(0.3, -0.1));
+            p.push_back(vec2(0.3, 0.1));
+            p.push_back(vec2(0.1, 0.1));
+            p.push_back(vec2(-0.1, 0.1));
+            p.push_back(vec2(-0.3, 0.1));
+            simulation.add_body(p);
+            simulation.multiple_bodies_mode_ = false;
+            break;
+        }
+
+        // setup problem 3
+        case 3:
+        {
+            simulation.clear_bodies(1, 8);
+
+            std::vector<vec2> p;
+            p.push_back(vec2(-0.5, 0.1));
+            p.push_back(vec2(-0.5, 0.0));
+            p.push_back(vec2(0.0, 0.0));
+            p.push_back(vec2(0.0, -0.3));
+            p.push_back(vec2(0.1, -0.3));
+            p.push_back(vec2(0.1, 0.0));
+            p.push_back(vec2(0.3, 0.0));
+            p.push_back(vec2(0.3, 0.1));
+            simulation.add_body(p);
+            simulation.multiple_bodies_mode_ = false;
+            break;
+        }
+
+        // setup problem 4
+        case 4:
+        {
+            if (previous != 4)
+            {
+                simulation.use_gravity_ = false;
+                simulation.damping_ = 0.0;
+                simulation.collision_elasticity_ = 0.9;
+                simulation.collision_damping_ = 0.0;
+                simulation.friction_ = 0.0;
+            }
+
+            simulation.clear_bodies(3, 12);
+
+            std::vector<vec2> p;
+            p.push_back(vec2(-0.6, -0.6));
+            p.push_back(vec2(-0.4, -0.6));
+            p.push_back(vec2(-0.4, -0.4));
+            simulation.add_body(p, vec2(0.2, 0.5));
+
+            std::vector<vec2> p2;
+            p2.push_back(vec2(0.6, 0.6));
+            p2.push_back(vec2(0.4, 0.6));
+            p2.push_back(vec2(0.4, 0.4));
+            p2.push_back(vec2(0.6, 0.4));
+            simulation.add_body(p2, vec2(0.4, 0.3));
+
+            std::vector<vec2> p3;
+            p3.push_back(vec2(0.7, -0.4));
+            p3.push_back(vec2(0.5, -0.25));
+            p3.push_back(vec2(0.3, -0.4));
+            p3.push_back(vec2(0.4, -0.6));
+            p3.push_back(vec2(0.6, -0.6));
+            simulation.add_body(p3, vec2(-0.4, 0.3));
+
+            simulation.multiple_bodies_mode_ = true;
+            break;
+        }
+
+        // pyramid of 210 boxes resting on the floor
+        case 5:
+        {
+            simulation.reset_parameters();
+
+            const int n_rows = 20;
+            const float size = 0.08, gap = 0.01;
+            simulation.clear_bodies(n_rows * (n_rows + 1) / 2,
+                                    2 * n_rows * (n_rows + 1));
+
+            std::vector<vec2> p(4);
+            for (int row = 0; row < n_rows; ++row)
+            {
+                const int n = n_rows - row;
+                const float y = -1.0 + row * size;
+                for (int i = 0; i < n; ++i)
+                {
+                    const float x = (i - 0.5 * (n - 1)) * (size + gap);
+                    p[0] = vec2(x - 0.5 * size, y);
+                    p[1] = vec2(x + 0.5 * size, y);
+                    p[2] = vec2(x + 0.5 * size, y + size);
+                    p[3] = vec2(x - 0.5 * size, y + size);
+                    simulation.add_body(p);
+                }
+            }
+
+            simulation.multiple_bodies_mode_ = true;
+            break;
+        }
+    }
+
+    if (previous == 4 && scene != 4)
+        simulation.reset_parameters();
+    simulation.scene_ = scene;
+
+    return true;
+}
+
+//=============================================================================
@@ -0,0 +1,27 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+#pragma once
+//=============================================================================
+
+#include "RigidBodySystem.h"
+
+//=============================================================================
+
+/// number of built-in scenes
+const int n_scenes = 5;
+
+/// replace the bodies of `simulation` by the built-in scene `scene` (1 to
+/// n_scenes). entering scene 4 (multiple colliding bodies) from another
+/// scene changes the parameters, they are reset when switching to another
+/// scene. scene 5 (a pyramid of boxes) starts with the default parameters.
+/// returns false for an invalid scene number.
+bool setup_scene(RigidBodySystem& simulation, int scene);
+
+//=============================================================================
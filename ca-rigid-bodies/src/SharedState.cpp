@@ -0,0 +1,284 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+
+#include "SharedState.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define HAVE_SHARED_MEMORY
+#endif
+
+//== IMPLEMENTATION ==========================================================
+
+// identifies our segments ("CASH" in little endian)
+static const uint32_t shared_state_magic = 0x48534143;
+
+// attempts to copy a consistent frame before a reader gives up, e.g. if the
+// writer died while writing a frame
+static const int max_read_attempts = 100;
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+              "shared memory needs lock-free atomics");
+
+//-----------------------------------------------------------------------------
+
+SharedState::SharedState()
+    : header_(nullptr), bytes_(0), writer_(false), frame_(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+SharedState::~SharedState()
+{
+    close();
+}
+
+//-----------------------------------------------------------------------------
+
+bool SharedState::create(const std::string& name, size_t capacity,
+                         unsigned int components, unsigned int n_slots)
+{
+    close();
+
+#ifdef HAVE_SHARED_MEMORY
+    // slots are cache-line aligned, so slots never share a cache line
+    const size_t slot_size =
+        (sizeof(Slot) + capacity * components * sizeof(float) + 63) & ~63;
+    const size_t bytes = ((sizeof(Header) + 63) & ~63) + n_slots * slot_size;
+
+    // replace a segment left behind by a crashed writer
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0)
+        return false;
+    if (ftruncate(fd, bytes) != 0 || !map(fd, bytes, true))
+    {
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+    ::close(fd);
+
+    // the segment is zero-filled, i.e., all sequence numbers are even
+    header_->n_slots = n_slots;
+    header_->components = components;
+    header_->slot_size = slot_size;
+    header_->capacity = capacity;
+    header_->frame.store(frame_, std::memory_order_relaxed);
+    header_->closed.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    header_->magic = shared_state_magic;
+
+    name_ = name;
+    writer_ = true;
+    return true;
+#else
+    (void)name;
+    (void)capacity;
+    (void)components;
+    (void)n_slots;
+    return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+bool SharedState::attach(const std::string& name)
+{
+    close();
+
+#ifdef HAVE_SHARED_MEMORY
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        return false;
+
+    struct stat s;
+    if (fstat(fd, &s) != 0 || size_t(s.st_size) < sizeof(Header) ||
+        !map(fd, s.st_size, false))
+    {
+        ::close(fd);
+        return false;
+    }
+    ::close(fd);
+
+    // a writer might still be initializing the header
+    if (header_->magic != shared_state_magic ||
+        bytes_ < sizeof(Header) + header_->n_slots * header_->slot_size)
+    {
+        close();
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    name_ = name;
+    writer_ = false;
+    return true;
+#else
+    (void)name;
+    return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+bool SharedState::map(int fd, size_t bytes, bool writable)
+{
+#ifdef HAVE_SHARED_MEMORY
+    const int protection = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    void* p = mmap(nullptr, bytes, protection, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED)
+        return false;
+    header_ = static_cast<Header*>(p);
+    bytes_ = bytes;
+    return true;
+#else
+    (void)fd;
+    (void)bytes;
+    (void)writable;
+    return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+void SharedState::close()
+{
+#ifdef HAVE_SHARED_MEMORY
+    if (header_)
+    {
+        if (writer_)
+        {
+            header_->closed.store(1, std::memory_order_release);
+            shm_unlink(name_.c_str());
+        }
+        munmap(header_, bytes_);
+    }
+#endif
+    header_ = nullptr;
+    bytes_ = 0;
+    writer_ = false;
+}
+
+//-----------------------------------------------------------------------------
+
+unsigned int SharedState::components() const
+{
+    return header_ ? header_->components : 0;
+}
+
+//-----------------------------------------------------------------------------
+
+SharedState::Slot* SharedState::slot(uint64_t number) const
+{
+    char* slots = reinterpret_cast<char*>(header_) +
+                  ((sizeof(Header) + 63) & ~63);
+    return reinterpret_cast<Slot*>(
+        slots + (number % header_->n_slots) * header_->slot_size);
+}
+
+//-----------------------------------------------------------------------------
+
+float* SharedState::begin_frame(size_t count)
+{
+    if (!header_ || !writer_)
+        return nullptr;
+
+    // too large: replace the segment by one with twice the needed capacity
+    if (count > header_->capacity)
+    {
+        const std::string name = name_;
+        const unsigned int components = header_->components;
+        const unsigned int n_slots = header_->n_slots;
+        if (!create(name, 2 * count, components, n_slots))
+            return nullptr;
+    }
+
+    // odd sequence number: readers of this slot will retry
+    Slot* s = slot(++frame_);
+    s->sequence.store(s->sequence.load(std::memory_order_relaxed) + 1,
+                      std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    s->number = frame_;
+    s->count = count;
+    return reinterpret_cast<float*>(s + 1);
+}
+
+//-----------------------------------------------------------------------------
+
+void SharedState::end_frame(double time)
+{
+    if (!header_ || !writer_)
+        return;
+
+    Slot* s = slot(frame_);
+    s->time = time;
+
+    // even sequence number: the slot is consistent again
+    s->sequence.store(s->sequence.load(std::memory_order_relaxed) + 1,
+                      std::memory_order_release);
+    header_->frame.store(frame_, std::memory_order_release);
+}
+
+//-----------------------------------------------------------------------------
+
+bool SharedState::read(Frame& frame) const
+{
+    if (!header_)
+        return false;
+
+    for (int attempt = 0; attempt < max_read_attempts; ++attempt)
+    {
+        const uint64_t number = header_->frame.load(std::memory_order_acquire);
+        if (number == 0 || number <= frame.number)
+            return false;
+
+        const Slot* s = slot(number);
+        const uint32_t before = s->sequence.load(std::memory_order_acquire);
+        if (before & 1)
+            continue;
+
+        // the copy may be torn by the writer, which is detected below
+        const uint64_t count =
+            std::min<uint64_t>(s->count, header_->capacity);
+        const size_t n = count * header_->components;
+        frame.data.resize(n);
+        std::memcpy(frame.data.data(), s + 1, n * sizeof(float));
+        const uint64_t slot_number = s->number;
+        const double time = s->time;
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (s->sequence.load(std::memory_order_relaxed) == before &&
+            slot_number == number)
+        {
+            frame.number = number;
+            frame.time = time;
+            frame.count = count;
+            return true;
+        }
+    }
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+
+bool SharedState::is_closed() const
+{
+    return header_ && header_->closed.load(std::memory_order_acquire);
+}
+
+//=============================================================================
@@ -0,0 +1,90 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+
+#include "SweepAndPrune.h"
+
+#include <algorithm>
+
+//== IMPLEMENTATION ==========================================================
+
+void SweepAndPrune::update(const std::vector<RigidBody>& bodies)
+{
+    const int n = bodies.size();
+    const bool rebuild = (int)order_.size() != n;
+
+    // bounding boxes, as cached by the bodies. sleeping bodies do not move,
+    // their boxes are kept.
+    boxes_.resize(n);
+    for (int i = 0; i < n; ++i)
+    {
+        if (bodies[i].sleeping && !rebuild && boxes_[i].sleeping)
+            continue;
+        boxes_[i].min = bodies[i].box_min;
+        boxes_[i].max = bodies[i].box_max;
+        boxes_[i].sleeping = bodies[i].sleeping;
+    }
+
+    auto less = [this](int a, int b) {
+        return boxes_[a].min[0] < boxes_[b].min[0];
+    };
+
+    if (rebuild)
+    {
+        // bodies have been added or removed: sort from scratch
+        order_.resize(n);
+        for (int i = 0; i < n; ++i)
+            order_[i] = i;
+        std::sort(order_.begin(), order_.end(), less);
+    }
+    else
+    {
+        // insertion sort, linear for an (almost) sorted order
+        for (int i = 1; i < n; ++i)
+        {
+            const int body = order_[i];
+            int j = i;
+            for (; j > 0 && less(body, order_[j - 1]); --j)
+                order_[j] = order_[j - 1];
+            order_[j] = body;
+        }
+    }
+
+    // sweep along x, test only boxes starting before the current one ends.
+    // sleeping bodies do not collide with each other.
+    pairs_.clear();
+    for (int i = 0; i < n; ++i)
+    {
+        const Box& a = boxes_[order_[i]];
+        for (int j = i + 1; j < n; ++j)
+        {
+            const Box& b = boxes_[order_[j]];
+            if (b.min[0] > a.max[0])
+                break;
+            if (a.sleeping && b.sleeping)
+                continue;
+            if (b.min[1] <= a.max[1] && a.min[1] <= b.max[1])
+                pairs_.push_back(std::minmax(order_[i], order_[j]));
+        }
+    }
+
+    // same order as testing all pairs, collision response depends on it
+    std::sort(pairs_.begin(), pairs_.end());
+}
+
+//-----------------------------------------------------------------------------
+
+void SweepAndPrune::clear()
+{
+    boxes_.clear();
+    order_.clear();
+    pairs_.clear();
+}
+
+//=============================================================================
@@ -0,0 +1,59 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+#pragma once
+//=============================================================================
+
+#include "RigidBody.h"
+
+#include <utility>
+#include <vector>
+
+//== CLASS DEFINITION =========================================================
+
+/** \class SweepAndPrune SweepAndPrune.h
+ Sweep-and-prune broadphase for body-body collisions. The bodies are kept
+ sorted by the lower x-bound of their axis-aligned bounding boxes. Since the
+ bodies move only a little per time step, the order of the previous step is
+ almost sorted and is repaired by insertion sort in nearly linear time. A
+ sweep along x then reports the pairs whose boxes overlap in x and y, only
+ those have to be tested by the narrowphase.
+ */
+class SweepAndPrune
+{
+public:
+    /// a pair of body indices (first < second)
+    typedef std::pair<int, int> Pair;
+
+    /// update the bounding boxes of `bodies` and find all overlapping pairs,
+    /// except pairs of sleeping bodies
+    void update(const std::vector<RigidBody>& bodies);
+
+    /// pairs with overlapping boxes found by update(), in lexicographic
+    /// order (the order of testing all pairs i < j)
+    const std::vector<Pair>& pairs() const { return pairs_; }
+
+    /// forget the order of the bodies (e.g. when bodies have been removed)
+    void clear();
+
+private:
+    /// axis-aligned bounding box
+    struct Box
+    {
+        vec2 min;      ///< lower bounds
+        vec2 max;      ///< upper bounds
+        bool sleeping; ///< is the body sleeping?
+    };
+
+    std::vector<Box> boxes_;  ///< bounding box of each body
+    std::vector<int> order_;  ///< bodies sorted by lower x-bound
+    std::vector<Pair> pairs_; ///< overlapping pairs
+};
+
+//=============================================================================
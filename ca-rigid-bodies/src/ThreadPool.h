@@ -0,0 +1,161 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+#pragma once
+//=============================================================================
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//== CLASS DEFINITION =========================================================
+
+/** \class ThreadPool ThreadPool.h
+ A work-stealing thread pool. Each worker has its own task queue. Workers take
+ tasks from the back of their own queue and, if it is empty, steal tasks from
+ the front of the other queues, which balances tasks of very different cost.
+ */
+class ThreadPool
+{
+public:
+    typedef std::function<void()> Task;
+
+    /// start `n_threads` workers (0: one per hardware thread)
+    explicit ThreadPool(unsigned int n_threads = 0)
+        : pending_(0), queued_(0), next_queue_(0), stop_(false)
+    {
+        if (!n_threads)
+            n_threads = std::max(1u, std::thread::hardware_concurrency());
+
+        for (unsigned int i = 0; i < n_threads; ++i)
+            queues_.emplace_back(new Queue);
+        for (unsigned int i = 0; i < n_threads; ++i)
+            threads_.emplace_back(&ThreadPool::worker, this, i);
+    }
+
+    /// finish all tasks and stop the workers
+    ~ThreadPool()
+    {
+        wait();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (std::thread& t : threads_)
+            t.join();
+    }
+
+    /// number of worker threads
+    unsigned int size() const { return threads_.size(); }
+
+    /// add a task, queues are filled round-robin
+    void submit(Task task)
+    {
+        ++pending_;
+        Queue& q = *queues_[next_queue_++ % queues_.size()];
+        {
+            std::lock_guard<std::mutex> lock(q.mutex);
+            q.tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++queued_;
+        }
+        wake_.notify_one();
+    }
+
+    /// block until all submitted tasks have been finished
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this] { return pending_ == 0; });
+    }
+
+private:
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// task queue of one worker
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    /// take a task from the own queue or steal one from another queue
+    bool pop(unsigned int i, Task& task)
+    {
+        for (unsigned int k = 0; k < queues_.size(); ++k)
+        {
+            Queue& q = *queues_[(i + k) % queues_.size()];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (!q.tasks.empty())
+            {
+                if (k == 0)
+                {
+                    task = std::move(q.tasks.back());
+                    q.tasks.pop_back();
+                }
+                else
+                {
+                    task = std::move(q.tasks.front());
+                    q.tasks.pop_front();
+                }
+                --queued_;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// main loop of worker `i`
+    void worker(unsigned int i)
+    {
+        for (;;)
+        {
+            Task task;
+            if (pop(i, task))
+            {
+                task();
+                if (--pending_ == 0)
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    done_.notify_all();
+                }
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this] { return stop_ || queued_ > 0; });
+            if (stop_ && queued_ == 0)
+                return;
+        }
+    }
+
+    std::vector<std::unique_ptr<Queue>> queues_; ///< one queue per worker
+    std::vector<std::thread> threads_;           ///< the workers
+
+    std::atomic<unsigned int> pending_;    ///< submitted, unfinished tasks
+    std::atomic<unsigned int> queued_;     ///< tasks waiting in queues
+    std::atomic<unsigned int> next_queue_; ///< queue for the next task
+    bool stop_;                            ///< shut down the workers?
+
+    std::mutex mutex_;             ///< protects sleeping and waking up
+    std::condition_variable wake_; ///< signals new tasks
+    std::condition_variable done_; ///< signals that all tasks are done
+};
+
+//=============================================================================
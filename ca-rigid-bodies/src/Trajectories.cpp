@@ -0,0 +1,235 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+
+#include "Trajectories.h"
+#include "RigidBodySystem.h"
+#include "Scenes.h"
+
+#include <pmp/Timer.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+
+//== IMPLEMENTATION ==========================================================
+
+// cases whose reference took less time are too short for timing checks
+static const double min_timing_seconds = 0.01;
+
+//-----------------------------------------------------------------------------
+
+// tolerance of `scene`. the boxes of the pyramid (scene 5) settle slightly
+// differently if the rounding changes, e.g. with fused multiply-adds.
+static float scene_tolerance(int scene, float tolerance)
+{
+    return scene == 5 ? 100.0f * tolerance : tolerance;
+}
+
+//-----------------------------------------------------------------------------
+
+Trajectories::Trajectories(int steps, int sample_interval)
+    : steps(steps), sample_interval(sample_interval)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+void Trajectories::simulate()
+{
+    cases.clear();
+    for (int scene = 1; scene <= n_scenes; ++scene)
+    {
+        RigidBodySystem simulation(false);
+        setup_scene(simulation, scene);
+
+        Case c;
+        c.scene = scene;
+        c.n_bodies = simulation.bodies_.size();
+
+        pmp::Timer timer;
+        for (int step = 1; step <= steps; ++step)
+        {
+            timer.cont();
+            simulation.time_integration();
+            timer.stop();
+
+            if (step % sample_interval == 0)
+            {
+                for (const RigidBody& b : simulation.bodies_)
+                {
+                    c.samples.push_back(b.position[0]);
+                    c.samples.push_back(b.position[1]);
+                    c.samples.push_back(b.orientation);
+                }
+            }
+        }
+        c.seconds = timer.elapsed() / 1000.0;
+
+        cases.push_back(c);
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+bool Trajectories::read(const std::string& filename)
+{
+    std::ifstream ifs(filename);
+    std::string header;
+    size_t n_cases;
+    if (!(ifs >> header >> steps >> sample_interval >> n_cases) ||
+        header != "trajectories")
+    {
+        std::cerr << "Trajectories: cannot read " << filename << std::endl;
+        return false;
+    }
+
+    // numbers are read as strings, since streams do not parse nan and inf
+    cases.resize(n_cases);
+    for (Case& c : cases)
+    {
+        size_t n_samples;
+        ifs >> c.scene >> c.n_bodies >> c.seconds >> n_samples;
+        c.samples.resize(n_samples);
+        std::string value;
+        for (float& s : c.samples)
+        {
+            ifs >> value;
+            s = std::strtof(value.c_str(), nullptr);
+        }
+    }
+
+    if (!ifs)
+    {
+        std::cerr << "Trajectories: cannot read " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool Trajectories::write(const std::string& filename) const
+{
+    std::ofstream ofs(filename);
+    if (!ofs)
+    {
+        std::cerr << "Trajectories: cannot write " << filename << std::endl;
+        return false;
+    }
+
+    // enough digits to read back the same floats
+    ofs.precision(9);
+    ofs << "trajectories " << steps << " " << sample_interval << " "
+        << cases.size() << "\n";
+    for (const Case& c : cases)
+    {
+        ofs << c.scene << " " << c.n_bodies << " " << c.seconds << " "
+            << c.samples.size();
+        for (float s : c.samples)
+            ofs << " " << s;
+        ofs << "\n";
+    }
+
+    return bool(ofs);
+}
+
+//-----------------------------------------------------------------------------
+
+bool Trajectories::compare(const Trajectories& reference, float tolerance,
+                           float max_slowdown, std::ostream& os) const
+{
+    bool passed = true;
+    if (steps != reference.steps ||
+        sample_interval != reference.sample_interval)
+    {
+        os << "different number of steps or sample interval\n";
+        return false;
+    }
+
+    for (const Case& r : reference.cases)
+    {
+        auto c = cases.begin();
+        while (c != cases.end() && c->scene != r.scene)
+            ++c;
+
+        os << "scene " << r.scene << ": ";
+        if (c == cases.end())
+        {
+            os << "FAILED (missing)\n";
+            passed = false;
+            continue;
+        }
+
+        if (c->n_bodies != r.n_bodies || c->samples.size() != r.samples.size())
+        {
+            os << "FAILED (" << c->n_bodies << " instead of " << r.n_bodies
+               << " bodies)\n";
+            passed = false;
+            continue;
+        }
+
+        // max. deviation of finite positions, blow-ups have to match
+        float deviation = 0.0;
+        bool blow_up = false, blow_up_mismatch = false;
+        for (size_t i = 0; i < r.samples.size(); ++i)
+        {
+            const bool finite = std::isfinite(r.samples[i]);
+            if (finite != std::isfinite(c->samples[i]))
+                blow_up_mismatch = true;
+            else if (finite)
+                deviation = std::max(
+                    deviation, std::fabs(c->samples[i] - r.samples[i]));
+            else
+                blow_up = true;
+        }
+
+        if (blow_up_mismatch)
+        {
+            os << "FAILED (blow-up differs)";
+            passed = false;
+        }
+        else if (deviation > scene_tolerance(r.scene, tolerance))
+        {
+            os << "FAILED (deviation " << deviation << ")";
+            passed = false;
+        }
+        else
+        {
+            os << "ok (deviation " << deviation
+               << (blow_up ? ", blows up" : "") << ")";
+        }
+
+        // throughput
+        os << ", " << 1000.0 * c->seconds << " ms (reference "
+           << 1000.0 * r.seconds << " ms) ";
+        if (max_slowdown <= 0.0)
+        {
+            os << "not checked\n";
+        }
+        else if (r.seconds < min_timing_seconds)
+        {
+            os << "too short for timing\n";
+        }
+        else if (c->seconds > max_slowdown * r.seconds)
+        {
+            os << "FAILED (too slow)\n";
+            passed = false;
+        }
+        else
+        {
+            os << "ok\n";
+        }
+    }
+
+    os << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed;
+}
+
+//=============================================================================
@@ -0,0 +1,72 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+#pragma once
+//=============================================================================
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+//== CLASS DEFINITION =========================================================
+
+/** \class Trajectories Trajectories.h
+ Golden trajectories for regression checks of the simulation. Every built-in
+ scene is simulated headless with its default parameters. Position and
+ orientation of the bodies are sampled at regular intervals, together with
+ the simulation time of each run.
+
+ A reference recorded once is compared to a new recording (e.g. after
+ refactoring the collision handling) with a tolerance on the samples and a
+ bound on the slowdown of each scene. Runs that blow up are recorded as NaN
+ and have to blow up in the comparison as well. The runs are short, since
+ stacks and colliding bodies amplify differences of rounding (e.g. fused
+ multiply-adds on other CPUs) over time.
+ */
+class Trajectories
+{
+public:
+    /// the trajectory of one scene
+    struct Case
+    {
+        int scene;                  ///< built-in scene (see Scenes.h)
+        int n_bodies;               ///< number of bodies
+        double seconds;             ///< simulation time (wall clock)
+        std::vector<float> samples; ///< (x,y,orientation) of all samples
+    };
+
+    /// constructor. each case simulates `steps` time steps and samples the
+    /// bodies every `sample_interval` steps.
+    Trajectories(int steps = 2000, int sample_interval = 100);
+
+    /// simulate all cases
+    void simulate();
+
+    /// read trajectories from a file
+    bool read(const std::string& filename);
+
+    /// write trajectories to a file
+    bool write(const std::string& filename) const;
+
+    /// compare to `reference`: positions and orientations must not deviate
+    /// by more than `tolerance` (100 times that for the pyramid of scene 5,
+    /// whose contacts depend on rounding already while it settles), each
+    /// scene must not be slower than
+    /// `max_slowdown` times the reference (timings are only reported if
+    /// `max_slowdown` <= 0). differences are reported to `os`.
+    bool compare(const Trajectories& reference, float tolerance,
+                 float max_slowdown, std::ostream& os) const;
+
+public:
+    int steps;               ///< time steps per case
+    int sample_interval;     ///< time steps between two samples
+    std::vector<Case> cases; ///< all cases
+};
+
+//=============================================================================
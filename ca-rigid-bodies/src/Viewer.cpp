@@ -9,9 +9,12 @@
 //=============================================================================
 
 #include <Viewer.h>
+#include <Scenes.h>
 #include <pmp/GL.h>
 #include <imgui.h>
+#include <algorithm>
 #include <chrono>
+#include <thread>
 
 using namespace pmp;
 using namespace std::chrono;
@@ -23,10 +26,10 @@ Viewer::Viewer(const char* _title, int _width, int _height)
 {
     animate_ = false;
     keyboard('1', 0, GLFW_PRESS, 0);
-    simulation_time_ = 100.0;
+    simulation_time_ = 0.0;
 
     clear_help_items();
-    add_help_item("1-4", "Initialize different scenes");
+    add_help_item("1-5", "Initialize different scenes");
     add_help_item("Space", "Start/stop simulation");
     add_help_item("S", "Single time step");
     add_help_item("Left mouse", "Drag mass points");
@@ -45,111 +48,16 @@ void Viewer::keyboard(int key, int code, int action, int mods)
     if (action != GLFW_PRESS && action != GLFW_REPEAT)
         return;
 
-    static int lastmode = -1;
     switch (key)
     {
-        // setup problem 1
+        // setup problems 1-5
         case '1':
-        {
-            simulation_.clear_bodies();
-
-            std::vector<vec2> p;
-            p.push_back(vec2(-0.6, -0.6));
-            p.push_back(vec2(-0.4, -0.6));
-            p.push_back(vec2(-0.4, -0.4));
-            p.push_back(vec2(-0.6, -0.4));
-            simulation_.add_body(p);
-            simulation_.multiple_bodies_mode_ = false;
-
-            if (lastmode == '4')
-                simulation_.reset_parameters();
-            lastmode = '1';
-            break;
-        }
-
-        // setup problem 2
         case '2':
-        {
-            simulation_.clear_bodies();
-
-            std::vector<vec2> p;
-            p.push_back(vec2(-0.3, -0.1));
-            p.push_back(vec2(-0.1, -0.1));
-            p.push_back(vec2(0.1, -0.1));
-            p.push_back(vec2(0.3, -0.1));
-            p.push_back(vec2(0.3, 0.1));
-            p.push_back(vec2(0.1, 0.1));
-            p.push_back(vec2(-0.1, 0.1));
-            p.push_back(vec2(-0.3, 0.1));
-            simulation_.add_body(p);
-            simulation_.multiple_bodies_mode_ = false;
-
-            if (lastmode == '4')
-                simulation_.reset_parameters();
-            lastmode = '2';
-            break;
-        }
-
-        // setup problem 3
         case '3':
-        {
-            simulation_.clear_bodies();
-
-            std::vector<vec2> p;
-            p.push_back(vec2(-0.5, 0.1));
-            p.push_back(vec2(-0.5, 0.0));
-            p.push_back(vec2(0.0, 0.0));
-            p.push_back(vec2(0.0, -0.3));
-            p.push_back(vec2(0.1, -0.3));
-            p.push_back(vec2(0.1, 0.0));
-            p.push_back(vec2(0.3, 0.0));
-            p.push_back(vec2(0.3, 0.1));
-            simulation_.add_body(p);
-            simulation_.multiple_bodies_mode_ = false;
-
-            if (lastmode == '4')
-                simulation_.reset_parameters();
-            lastmode = '3';
-            break;
-        }
-
-        // setup problem 4
         case '4':
+        case '5':
         {
-            if (lastmode != '4')
-            {
-                simulation_.use_gravity_ = false;
-                simulation_.damping_ = 0.0;
-                simulation_.collision_elasticity_ = 0.9;
-                simulation_.collision_damping_ = 0.0;
-            }
-
-            simulation_.clear_bodies();
-
-            std::vector<vec2> p;
-            p.push_back(vec2(-0.6, -0.6));
-            p.push_back(vec2(-0.4, -0.6));
-            p.push_back(vec2(-0.4, -0.4));
-            simulation_.add_body(p, vec2(0.2, 0.5));
-
-            std::vector<vec2> p2;
-            p2.push_back(vec2(0.6, 0.6));
-            p2.push_back(vec2(0.4, 0.6));
-            p2.push_back(vec2(0.4, 0.4));
-            p2.push_back(vec2(0.6, 0.4));
-            simulation_.add_body(p2, vec2(0.4, 0.3));
-
-            std::vector<vec2> p3;
-            p3.push_back(vec2(0.7, -0.4));
-            p3.push_back(vec2(0.5, -0.25));
-            p3.push_back(vec2(0.3, -0.4));
-            p3.push_back(vec2(0.4, -0.6));
-            p3.push_back(vec2(0.6, -0.6));
-            simulation_.add_body(p3, vec2(-0.4, 0.3));
-
-            simulation_.multiple_bodies_mode_ = true;
-
-            lastmode = '4';
+            setup_scene(simulation_, key - '0');
             break;
         }
 
@@ -211,12 +119,31 @@ void Viewer::do_processing()
             {
                 simulation_.time_integration();
             }
+            simulation_time_ += 20 * simulation_.time_step_;
+            publish_state();
         }
     }
 }
 
 //-----------------------------------------------------------------------------
 
+void Viewer::publish_state()
+{
+    float* data = shared_state_.begin_frame(simulation_.bodies_.size());
+    if (!data)
+        return;
+
+    for (const RigidBody& b : simulation_.bodies_)
+    {
+        *data++ = b.position[0];
+        *data++ = b.position[1];
+        *data++ = b.orientation;
+    }
+    shared_state_.end_frame(simulation_time_);
+}
+
+//-----------------------------------------------------------------------------
+
 void Viewer::process_imgui()
 {
     if (ImGui::CollapsingHeader("Time Integration",
@@ -266,6 +193,117 @@ void Viewer::process_imgui()
                            2.0);
 
         ImGui::PopItemWidth();
+
+        ImGui::Spacing();
+        ImGui::Text("Friction:");
+        ImGui::SliderFloat("##Friction", &simulation_.friction_, 0.0f, 1.0f,
+                           "%.2f");
+
+        ImGui::Spacing();
+        ImGui::Text("Solver Iterations:");
+        ImGui::SliderInt("##Iterations", &simulation_.solver_iterations_, 1,
+                         50);
+        ImGui::Checkbox("Warm Starting", &simulation_.use_warm_starting_);
+        ImGui::Checkbox("Contact Cache", &simulation_.use_contact_cache_);
+
+        ImGui::Spacing();
+        ImGui::Text("Threads:");
+        ImGui::SliderInt("##Threads", &simulation_.n_threads_, 1,
+                         std::max(1u, std::thread::hardware_concurrency()));
+
+        ImGui::Spacing();
+        ImGui::Checkbox("AABB Tree Broadphase", &simulation_.use_aabb_tree_);
+
+        ImGui::Spacing();
+        ImGui::Checkbox("Sleeping", &simulation_.use_sleeping_);
+        ImGui::PushItemWidth(120);
+        ImGui::SliderFloat("Sleep Velocity", &simulation_.sleep_velocity_,
+                           0.0f, 0.2f, "%.3f", 2.0);
+        ImGui::SliderFloat("Sleep Time", &simulation_.sleep_time_, 0.0f, 5.0f,
+                           "%.2f");
+        ImGui::PopItemWidth();
+        ImGui::Text("Sleeping bodies: %d", simulation_.n_sleeping());
+    }
+
+    if (ImGui::CollapsingHeader("Timings"))
+    {
+        ImGui::Checkbox("Measure Timings", &simulation_.profiler_.enabled);
+
+        // rolling statistics of the last steps, in milliseconds
+        ImGui::Columns(4, "timings", false);
+        ImGui::Text("Phase");
+        ImGui::NextColumn();
+        ImGui::Text("min");
+        ImGui::NextColumn();
+        ImGui::Text("avg");
+        ImGui::NextColumn();
+        ImGui::Text("p99");
+        ImGui::NextColumn();
+        for (const char* phase : simulation_.profiler_.phases())
+        {
+            Profiler::Statistics stats = simulation_.profiler_.statistics(phase);
+            ImGui::Text("%s", phase);
+            ImGui::NextColumn();
+            ImGui::Text("%.3f", stats.min);
+            ImGui::NextColumn();
+            ImGui::Text("%.3f", stats.avg);
+            ImGui::NextColumn();
+            ImGui::Text("%.3f", stats.p99);
+            ImGui::NextColumn();
+        }
+        ImGui::Columns(1);
+
+        ImGui::Spacing();
+
+        // record a trace for chrome://tracing or ui.perfetto.dev
+        if (!simulation_.profiler_.is_tracing())
+        {
+            if (ImGui::Button("Record Trace"))
+                simulation_.profiler_.start_trace();
+        }
+        else if (ImGui::Button("Stop Trace"))
+        {
+            simulation_.profiler_.stop_trace();
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Save Trace"))
+        {
+            simulation_.profiler_.write_trace("trace.json");
+        }
+        ImGui::Text("%d events recorded",
+                    (int)simulation_.profiler_.n_trace_events());
+
+        ImGui::Spacing();
+        ImGui::Spacing();
+    }
+
+#ifndef __EMSCRIPTEN__
+    if (ImGui::CollapsingHeader("Shared Memory"))
+    {
+        // x, y, orientation of each frame, for external visualizers
+        bool publish = shared_state_.is_open();
+        if (ImGui::Checkbox("Publish Bodies", &publish))
+        {
+            if (publish)
+                shared_state_.create("/rigid_bodies",
+                                     simulation_.bodies_.size(), 3);
+            else
+                shared_state_.close();
+        }
+        if (shared_state_.is_open())
+        {
+            ImGui::Text("Segment: %s", shared_state_.name().c_str());
+        }
+
+        ImGui::Spacing();
+        ImGui::Spacing();
+    }
+#endif
+
+    // changed parameters may disturb resting bodies
+    if (simulation_.n_sleeping() && ImGui::IsAnyItemActive())
+    {
+        simulation_.wake_up();
     }
 }
 
@@ -11,6 +11,7 @@
 //=============================================================================
 
 #include "RigidBodySystem.h"
+#include "SharedState.h"
 
 #include <pmp/Window.h>
 #include <pmp/Shader.h>
@@ -56,6 +57,10 @@ private: // GUI functions
     /// pick a 2D point by mouse clicking
     vec2 pick(int _x, int _y);
 
+    /// publish position and orientation of the bodies to shared memory (if
+    /// enabled)
+    void publish_state();
+
 private: // simulation data and settings
     /// the mass spring system to be simulated
     RigidBodySystem simulation_;
@@ -69,6 +74,9 @@ private: // simulation data and settings
     /// simulation time
     double simulation_time_;
 
+    /// shared memory the state of the bodies is published to
+    SharedState shared_state_;
+
     /// selected particle for mouse spring
     int mouse_spring_;
 };
@@ -9,11 +9,85 @@
 //=============================================================================
 
 #include "Viewer.h"
+#include "FrameWriter.h"
+#include "Scenes.h"
+#include "Trajectories.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+//=============================================================================
+
+#ifndef __EMSCRIPTEN__
+// simulate built-in scene `scene` headless and write `n_frames` frames of
+// 20 time steps (as shown by the viewer) as PNG images
+static int export_frames(int scene, int n_frames, const std::string& directory)
+{
+    RigidBodySystem simulation(false);
+    if (!setup_scene(simulation, scene))
+    {
+        std::cerr << "Cannot setup scene " << scene << std::endl;
+        return 1;
+    }
+
+    Rasterizer rasterizer(800, 800);
+    FrameWriter writer(directory);
+    for (int frame = 0; frame < n_frames; ++frame)
+    {
+        simulation.rasterize(rasterizer);
+        writer.write(rasterizer);
+
+        for (int i = 0; i < 20; ++i)
+            simulation.time_integration();
+    }
+
+    if (!writer.finish())
+    {
+        std::cerr << "Cannot write frames to " << directory << std::endl;
+        return 1;
+    }
+    return 0;
+}
+#endif
 
 //=============================================================================
 
 int main(int argc, char **argv)
 {
+#ifndef __EMSCRIPTEN__
+    // headless video export:
+    // rigid_bodies --export <scene number> <frames> <directory>
+    if (argc == 5 && std::string(argv[1]) == "--export")
+    {
+        return export_frames(atoi(argv[2]), atoi(argv[3]), argv[4]);
+    }
+
+    // regression check against golden trajectories:
+    // rigid_bodies --record <trajectories.txt>
+    // rigid_bodies --check <trajectories.txt> [tolerance] [max. slowdown]
+    if (argc == 3 && std::string(argv[1]) == "--record")
+    {
+        Trajectories trajectories;
+        trajectories.simulate();
+        return trajectories.write(argv[2]) ? 0 : 1;
+    }
+    if (argc >= 3 && std::string(argv[1]) == "--check")
+    {
+        Trajectories reference;
+        if (!reference.read(argv[2]))
+            return 1;
+        Trajectories trajectories(reference.steps, reference.sample_interval);
+        trajectories.simulate();
+        const float tolerance = argc > 3 ? atof(argv[3]) : 1e-4;
+        const float max_slowdown = argc > 4 ? atof(argv[4]) : 1.5;
+        return trajectories.compare(reference, tolerance, max_slowdown,
+                                    std::cout)
+                   ? 0
+                   : 1;
+    }
+#endif
+
     Viewer viewer("Rigid Bodies", 800, 600);
     return viewer.run();
 }
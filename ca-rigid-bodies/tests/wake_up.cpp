@@ -0,0 +1,114 @@
+//=============================================================================
+//
+//   Exercise code for the lecture
+//   "Computer Animation"
+//   by Prof. Dr. Mario Botsch, TU Dortmund
+//
+//   Copyright  Computer Graphics Group, TU Dortmund.
+//
+//=============================================================================
+
+// A box thrown against a sleeping stack wakes it up. In the step the stack
+// wakes up, its boxes must rest on the floor and on each other, i.e., none
+// of them may move down. Boxes without contacts would fall by g dt^2 (about
+// 1e-5), boxes pushed by the thrown one without their floor contacts sink
+// even deeper.
+//
+// usage: wake_up [aabb_tree]
+
+#include "RigidBodyAPI.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+//=============================================================================
+
+// add a box of half size `h` centered at (x,y)
+static void add_box(rb_system* system, float x, float y, float h, float vx)
+{
+    const float points[] = {x - h, y - h, x + h, y - h,
+                            x + h, y + h, x - h, y + h};
+    rb_add_body(system, points, 4, vx, 0.0f);
+}
+
+//-----------------------------------------------------------------------------
+
+// vertical position of body i
+static float height(const rb_system* system, size_t i)
+{
+    const rb_view view = rb_positions(system);
+    return ((const float*)((const char*)view.data + i * view.stride))[1];
+}
+
+//=============================================================================
+
+int main(int argc, char** argv)
+{
+    // a step may lower a box by less than this (solver tolerance)
+    const float tolerance = 1e-6f;
+    // the contacts of the woken stack start cold, enough iterations such
+    // that the solver converges within the tolerance
+    const int n_stack = 4;
+
+    rb_system* system = rb_create();
+    rb_clear(system, n_stack + 1, 4 * (n_stack + 1));
+    rb_set_parameter(system, "body_collisions", 1);
+    rb_set_parameter(system, "sleeping", 1);
+    rb_set_parameter(system, "solver_iterations", 100);
+    rb_set_parameter(system, "aabb_tree", argc > 1 ? atoi(argv[1]) : 0);
+
+    // stack of boxes on the floor at y = -1, which settles and falls asleep
+    // (sleep_time is 0.5 s, i.e., 500 steps). boxes at rest do not move even
+    // when awake, so the sleeping stack must not move for longer than that.
+    for (int i = 0; i < n_stack; ++i)
+        add_box(system, 0.0f, -0.9f + 0.2f * i, 0.1f, 0.0f);
+    rb_step(system, 1000);
+    std::vector<float> y(n_stack);
+    for (int i = 0; i < n_stack; ++i)
+        y[i] = height(system, i);
+    rb_step(system, 1000);
+    for (int i = 0; i < n_stack; ++i)
+    {
+        if (height(system, i) != y[i])
+        {
+            printf("wake_up: the stack did not fall asleep\n");
+            rb_destroy(system);
+            return 1;
+        }
+    }
+
+    // throw a small box against the bottom box of the stack, it hits it
+    // while falling
+    add_box(system, -0.5f, -0.7f, 0.05f, 2.0f);
+    for (int step = 0; step < 1000; ++step)
+    {
+        for (int i = 0; i < n_stack; ++i)
+            y[i] = height(system, i);
+        rb_step(system, 1);
+
+        // first step in which the stack moves: it has woken up
+        bool moved = false;
+        for (int i = 0; i < n_stack; ++i)
+            moved = moved || height(system, i) != y[i];
+        if (!moved)
+            continue;
+
+        bool passed = true;
+        for (int i = 0; i < n_stack; ++i)
+        {
+            const float dy = height(system, i) - y[i];
+            printf("wake_up: box %d moves by %g in step %d\n", i, dy, step);
+            passed = passed && dy > -tolerance;
+        }
+        printf(passed ? "PASSED\n" : "FAILED\n");
+        rb_destroy(system);
+        return passed ? 0 : 1;
+    }
+
+    printf("wake_up: the stack did not wake up\n");
+    rb_destroy(system);
+    return 1;
+}
+
+//=============================================================================